@@ -41,563 +41,5144 @@
 /***************************** Include Files **********************************/
 /******************************************************************************/
 #include <malloc.h>
+#include <string.h>
 #include "adf4377.h"
 #include "error.h"
 #include "delay.h"
 
+/******************************************************************************/
+/********************** Macros and Constants Definitions **********************/
+/******************************************************************************/
+#ifdef ADF4377_STATS
+#define ADF4377_STATS_INC(dev, counter)	((dev)->stats.counter++)
+#else
+#define ADF4377_STATS_INC(dev, counter)	do {} while (0)
+#endif
+
+#if defined(ADF4377_SPI_MSB_FIRST_ONLY) && defined(ADF4377_SPI_LSB_FIRST_ONLY)
+#error "ADF4377_SPI_MSB_FIRST_ONLY and ADF4377_SPI_LSB_FIRST_ONLY are exclusive"
+#endif
+
+#if defined(ADF4377_SPI_MSB_FIRST_ONLY)
+#define ADF4377_SPI_FIXED_BIT_ORDER	SPI_BIT_ORDER_MSB_FIRST
+#define ADF4377_SPI_LSB_FIRST(dev)	false
+#elif defined(ADF4377_SPI_LSB_FIRST_ONLY)
+#define ADF4377_SPI_FIXED_BIT_ORDER	SPI_BIT_ORDER_LSB_FIRST
+#define ADF4377_SPI_LSB_FIRST(dev)	true
+#else
+#define ADF4377_SPI_LSB_FIRST(dev)	\
+	((dev)->spi_desc->bit_order == SPI_BIT_ORDER_LSB_FIRST)
+#endif
+
+#if ADF4377_TRACE_SIZE & (ADF4377_TRACE_SIZE - 1)
+#error "ADF4377_TRACE_SIZE must be a power of two"
+#endif
+
+#if defined(ADF4377_ADF4377_ONLY) && defined(ADF4377_ADF4378_ONLY)
+#error "ADF4377_ADF4377_ONLY and ADF4377_ADF4378_ONLY are exclusive"
+#endif
+
+#if defined(ADF4377_ADF4377_ONLY)
+#define ADF4377_CHIP_INFO(dev)		(&adf4377_chip_info)
+#define ADF4377_DEV_SUPPORTED(id)	((id) == ADF4377)
+#elif defined(ADF4377_ADF4378_ONLY)
+#define ADF4377_CHIP_INFO(dev)		(&adf4378_chip_info)
+#define ADF4377_DEV_SUPPORTED(id)	((id) == ADF4378)
+#else
+#define ADF4377_CHIP_INFO(dev)		\
+	((dev)->dev_id == ADF4378 ? &adf4378_chip_info : &adf4377_chip_info)
+#define ADF4377_DEV_SUPPORTED(id)	((id) == ADF4377 || (id) == ADF4378)
+#endif
+
+/******************************************************************************/
+/************************ Variables Definitions *******************************/
+/******************************************************************************/
+/* Calibration clock dividers by PFD frequency, in ascending brackets. The
+ * clock is kept within the range of the calibration state machine. */
+static const struct adf4377_dclk_step adf4377_dclk_steps[] = {
+	{ ADF4377_FREQ_PFD_80MHZ, ADF4377_DCLK_DIV1_1, ADF4377_DCLK_DIV2_1, ADF4377_DCLK_MODE_DIS, 0 },
+	{ ADF4377_FREQ_PFD_125MHZ, ADF4377_DCLK_DIV1_1, ADF4377_DCLK_DIV2_1, ADF4377_DCLK_MODE_EN, 0 },
+	{ ADF4377_FREQ_PFD_160MHZ, ADF4377_DCLK_DIV1_2, ADF4377_DCLK_DIV2_1, ADF4377_DCLK_MODE_DIS, 1 },
+	{ ADF4377_FREQ_PFD_250MHZ, ADF4377_DCLK_DIV1_2, ADF4377_DCLK_DIV2_1, ADF4377_DCLK_MODE_EN, 1 },
+	{ ADF4377_FREQ_PFD_320MHZ, ADF4377_DCLK_DIV1_2, ADF4377_DCLK_DIV2_2, ADF4377_DCLK_MODE_DIS, 2 },
+	{ ADF4377_MAX_FREQ_PFD, ADF4377_DCLK_DIV1_2, ADF4377_DCLK_DIV2_2, ADF4377_DCLK_MODE_EN, 2 },
+};
+
+/* Reserved bits programmed at setup, common to all the variants. The masks
+ * and values are literals, the field macros are not constant expressions. */
+static const struct adf4377_reg_default adf4377_defaults[] = {
+	{ ADF4377_REG(0x0F), 0xFF, ADF4377_R00F_RSV1 },
+	{ ADF4377_REG(0x1C), 0x01, 0x01 },
+	{ ADF4377_REG(0x1F), 0x07, 0x07 },
+	{ ADF4377_REG(0x20), 0x01, 0x01 },
+	{ ADF4377_REG(0x21), 0xFF, ADF4377_R021_RSV1 },
+	{ ADF4377_REG(0x22), 0xFF, ADF4377_R022_RSV1 },
+	{ ADF4377_REG(0x23), 0xFF, ADF4377_R023_RSV1 },
+	{ ADF4377_REG(0x25), 0x16, 0x16 },
+	{ ADF4377_REG(0x2C), 0xFF, ADF4377_R02C_RSV1 },
+	{ ADF4377_REG(0x31), 0xFF, ADF4377_R031_RSV1 },
+	{ ADF4377_REG(0x32), 0x09, 0x09 },
+	{ ADF4377_REG(0x33), 0xFF, ADF4377_R033_RSV1 },
+	{ ADF4377_REG(0x34), 0xFF, ADF4377_R034_RSV1 },
+	{ ADF4377_REG(0x3A), 0xFF, ADF4377_R03A_RSV1 },
+	{ ADF4377_REG(0x3B), 0xFF, ADF4377_R03B_RSV1 },
+	{ ADF4377_REG(0x42), 0xFF, ADF4377_R042_RSV1 },
+};
+
+#ifndef ADF4377_ADF4378_ONLY
+static const struct adf4377_chip_info adf4377_chip_info = {
+	.chip_type = ADF4377_CHIP_TYPE,
+	.num_outputs = 2,
+	.min_freq = ADF4377_MIN_CLKPN_FREQ,
+	.max_freq = ADF4377_MAX_CLKPN_FREQ,
+	.defaults = adf4377_defaults,
+	.num_defaults = ARRAY_SIZE(adf4377_defaults),
+};
+#endif
+
+#ifndef ADF4377_ADF4377_ONLY
+/* Single output variant, CLKOUT2 and ENCLK2 are not available */
+static const struct adf4377_chip_info adf4378_chip_info = {
+	.chip_type = ADF4378_CHIP_TYPE,
+	.num_outputs = 1,
+	.min_freq = ADF4378_MIN_CLKPN_FREQ,
+	.max_freq = ADF4378_MAX_CLKPN_FREQ,
+	.defaults = adf4377_defaults,
+	.num_defaults = ARRAY_SIZE(adf4377_defaults),
+};
+#endif
+
+#ifndef ADF4377_SPI_MSB_FIRST_ONLY
+/* Bit reversed byte values, for LSB first SPI framing */
+static const uint8_t adf4377_bit_rev[256] = {
+	0x00, 0x80, 0x40, 0xC0, 0x20, 0xA0, 0x60, 0xE0, 0x10, 0x90, 0x50, 0xD0, 0x30, 0xB0, 0x70, 0xF0,
+	0x08, 0x88, 0x48, 0xC8, 0x28, 0xA8, 0x68, 0xE8, 0x18, 0x98, 0x58, 0xD8, 0x38, 0xB8, 0x78, 0xF8,
+	0x04, 0x84, 0x44, 0xC4, 0x24, 0xA4, 0x64, 0xE4, 0x14, 0x94, 0x54, 0xD4, 0x34, 0xB4, 0x74, 0xF4,
+	0x0C, 0x8C, 0x4C, 0xCC, 0x2C, 0xAC, 0x6C, 0xEC, 0x1C, 0x9C, 0x5C, 0xDC, 0x3C, 0xBC, 0x7C, 0xFC,
+	0x02, 0x82, 0x42, 0xC2, 0x22, 0xA2, 0x62, 0xE2, 0x12, 0x92, 0x52, 0xD2, 0x32, 0xB2, 0x72, 0xF2,
+	0x0A, 0x8A, 0x4A, 0xCA, 0x2A, 0xAA, 0x6A, 0xEA, 0x1A, 0x9A, 0x5A, 0xDA, 0x3A, 0xBA, 0x7A, 0xFA,
+	0x06, 0x86, 0x46, 0xC6, 0x26, 0xA6, 0x66, 0xE6, 0x16, 0x96, 0x56, 0xD6, 0x36, 0xB6, 0x76, 0xF6,
+	0x0E, 0x8E, 0x4E, 0xCE, 0x2E, 0xAE, 0x6E, 0xEE, 0x1E, 0x9E, 0x5E, 0xDE, 0x3E, 0xBE, 0x7E, 0xFE,
+	0x01, 0x81, 0x41, 0xC1, 0x21, 0xA1, 0x61, 0xE1, 0x11, 0x91, 0x51, 0xD1, 0x31, 0xB1, 0x71, 0xF1,
+	0x09, 0x89, 0x49, 0xC9, 0x29, 0xA9, 0x69, 0xE9, 0x19, 0x99, 0x59, 0xD9, 0x39, 0xB9, 0x79, 0xF9,
+	0x05, 0x85, 0x45, 0xC5, 0x25, 0xA5, 0x65, 0xE5, 0x15, 0x95, 0x55, 0xD5, 0x35, 0xB5, 0x75, 0xF5,
+	0x0D, 0x8D, 0x4D, 0xCD, 0x2D, 0xAD, 0x6D, 0xED, 0x1D, 0x9D, 0x5D, 0xDD, 0x3D, 0xBD, 0x7D, 0xFD,
+	0x03, 0x83, 0x43, 0xC3, 0x23, 0xA3, 0x63, 0xE3, 0x13, 0x93, 0x53, 0xD3, 0x33, 0xB3, 0x73, 0xF3,
+	0x0B, 0x8B, 0x4B, 0xCB, 0x2B, 0xAB, 0x6B, 0xEB, 0x1B, 0x9B, 0x5B, 0xDB, 0x3B, 0xBB, 0x7B, 0xFB,
+	0x07, 0x87, 0x47, 0xC7, 0x27, 0xA7, 0x67, 0xE7, 0x17, 0x97, 0x57, 0xD7, 0x37, 0xB7, 0x77, 0xF7,
+	0x0F, 0x8F, 0x4F, 0xCF, 0x2F, 0xAF, 0x6F, 0xEF, 0x1F, 0x9F, 0x5F, 0xDF, 0x3F, 0xBF, 0x7F, 0xFF,
+};
+#endif
+
 /******************************************************************************/
 /************************** Functions Implementation **************************/
 /******************************************************************************/
 
 /**
- * @brief Writes data to ADF4377 over SPI.
+ * @brief Check if a register must bypass the shadow cache.
+ * @param reg_addr - The register address.
+ * @return Returns true for status and self-clearing registers, false otherwise.
+ */
+static bool adf4377_reg_volatile(uint8_t reg_addr)
+{
+	if (reg_addr >= ADF4377_REGMAP_SIZE)
+		return true;
+
+	switch (reg_addr) {
+	/* Self-clearing soft reset bits */
+	case ADF4377_REG(0x00):
+	/* Self-clearing ADC start conversion */
+	case ADF4377_REG(0x45):
+	/* LOCKED, FSM_BUSY, ADC_BUSY, REF_OK */
+	case ADF4377_REG(0x49):
+	/* VCO_CORE readback */
+	case ADF4377_REG(0x4B):
+	/* CHIP_TEMP */
+	case ADF4377_REG(0x4C):
+	case ADF4377_REG(0x4D):
+	/* VCO_BAND readback */
+	case ADF4377_REG(0x4F):
+		return true;
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief Check if a register value is held in the shadow cache.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @return Returns true if the cached value can be used, false otherwise.
+ */
+static bool adf4377_reg_cached(struct adf4377_dev *dev, uint8_t reg_addr)
+{
+	if (adf4377_reg_volatile(reg_addr))
+		return false;
+
+	return dev->regmap_valid[reg_addr / 8] & BIT(reg_addr % 8);
+}
+
+/**
+ * @brief Store a register value in the shadow cache.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param data - The register value.
+ * @return None.
+ */
+static void adf4377_reg_cache(struct adf4377_dev *dev, uint8_t reg_addr,
+			      uint8_t data)
+{
+	if (adf4377_reg_volatile(reg_addr))
+		return;
+
+	dev->regmap[reg_addr] = data;
+	dev->regmap_valid[reg_addr / 8] |= BIT(reg_addr % 8);
+}
+
+/**
+ * @brief Drop all the register values held in the shadow cache.
+ * @param dev - The device structure.
+ * @return None.
+ */
+void adf4377_regmap_invalidate(struct adf4377_dev *dev)
+{
+	memset(dev->regmap_valid, 0, sizeof(dev->regmap_valid));
+}
+
+#ifdef ADF4377_STATS
+/**
+ * @brief Clear the instrumentation data.
+ * @param dev - The device structure.
+ * @return None.
+ */
+void adf4377_stats_reset(struct adf4377_dev *dev)
+{
+	memset(&dev->stats, 0, sizeof(dev->stats));
+	dev->stats.lock_min_us = UINT32_MAX;
+}
+#endif
+
+/**
+ * @brief Set the phase the following bus accesses and delays are accounted to.
+ * @param dev - The device structure.
+ * @param phase - The driver phase.
+ * @return None.
+ */
+static void adf4377_set_phase(struct adf4377_dev *dev, enum adf4377_phase phase)
+{
+#ifdef ADF4377_STATS
+	dev->phase = phase;
+#endif
+}
+
+/**
+ * @brief Record a lock time measurement.
+ * @param dev - The device structure.
+ * @param lock_us - The lock time in us.
+ * @return None.
+ */
+static void adf4377_stats_lock(struct adf4377_dev *dev, uint32_t lock_us)
+{
+#ifdef ADF4377_STATS
+	struct adf4377_stats *stats = &dev->stats;
+
+	stats->lock_count++;
+	stats->lock_sum_us += lock_us;
+	if (lock_us < stats->lock_min_us)
+		stats->lock_min_us = lock_us;
+	if (lock_us > stats->lock_max_us)
+		stats->lock_max_us = lock_us;
+	stats->lock_hist[min(lock_us / ADF4377_LOCK_HIST_BIN_US,
+			     ADF4377_LOCK_HIST_BINS - 1)]++;
+#endif
+}
+
+/**
+ * @brief Take the device lock, if any.
+ *
+ * The lock serializes the multi-register sequences of the tasks sharing the
+ * device. It is taken once per public call, the sequences calling each other
+ * through their _unlocked variants, so it does not need to be recursive.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_lock(struct adf4377_dev *dev)
+{
+	if (!dev->dev_lock)
+		return SUCCESS;
+
+	return dev->dev_lock->lock(dev->dev_lock->ctx);
+}
+
+/**
+ * @brief Release the device lock, if any.
+ * @param dev - The device structure.
+ * @return None.
+ */
+static void adf4377_unlock(struct adf4377_dev *dev)
+{
+	if (dev->dev_lock)
+		dev->dev_lock->unlock(dev->dev_lock->ctx);
+}
+
+/**
+ * @brief Take the SPI bus lock unless the device already holds it.
+ *
+ * The bus is held for one transfer, or for all the runs of a batch flush,
+ * never across delays, so the devices sharing the controller interleave at
+ * transfer or flush boundaries.
+ * @param dev - The device structure.
+ * @param taken - Set if the lock was taken and must be released.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_bus_get(struct adf4377_dev *dev, bool *taken)
+{
+	int32_t ret;
+
+	*taken = false;
+
+	if (!dev->bus_lock || dev->bus_held)
+		return SUCCESS;
+
+	ret = dev->bus_lock->lock(dev->bus_lock->ctx);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->bus_held = true;
+	*taken = true;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Release the SPI bus lock taken by adf4377_bus_get().
+ * @param dev - The device structure.
+ * @param taken - The lock was taken by the matching adf4377_bus_get().
+ * @return None.
+ */
+static void adf4377_bus_put(struct adf4377_dev *dev, bool taken)
+{
+	if (!taken)
+		return;
+
+	dev->bus_held = false;
+	dev->bus_lock->unlock(dev->bus_lock->ctx);
+}
+
+/**
+ * @brief Convert a byte between its register value and its SPI frame value.
+ * @param dev - The device structure.
+ * @param val - The byte to convert.
+ * @return The byte bit reversed in LSB first mode, unchanged otherwise.
+ */
+static uint8_t adf4377_spi_byte(struct adf4377_dev *dev, uint8_t val)
+{
+#ifndef ADF4377_SPI_MSB_FIRST_ONLY
+	if (ADF4377_SPI_LSB_FIRST(dev))
+		return adf4377_bit_rev[val];
+#endif
+
+	return val;
+}
+
+/**
+ * @brief Position of a register value inside a streaming transfer.
+ * @param dev - The device structure.
+ * @param len - Number of registers in the block.
+ * @param i - Offset of the register from the lowest address of the block.
+ * @return Returns the buffer index of the register value.
+ */
+static uint8_t adf4377_spi_burst_pos(struct adf4377_dev *dev, uint8_t len,
+				     uint8_t i)
+{
+	if (dev->addr_asc == ADF4377_ADDR_ASC_AUTO_DECR)
+		return ADF4377_SPI_INSTR_BYTES + len - 1 - i;
+
+	return ADF4377_SPI_INSTR_BYTES + i;
+}
+
+#ifdef ADF4377_TRACE
+/**
+ * @brief Clear the SPI trace.
+ * @param dev - The device structure.
+ * @return None.
+ */
+void adf4377_trace_reset(struct adf4377_dev *dev)
+{
+	memset(&dev->trace, 0, sizeof(dev->trace));
+}
+
+/**
+ * @brief Take the oldest records out of the SPI trace.
+ * @param dev - The device structure.
+ * @param recs - The records, oldest first.
+ * @param max - Maximum number of records.
+ * @return Returns the number of records taken.
+ */
+uint16_t adf4377_trace_read(struct adf4377_dev *dev,
+			    struct adf4377_trace_rec *recs, uint16_t max)
+{
+	struct adf4377_trace *trace = &dev->trace;
+	uint16_t i, num = min(max, trace->count);
+
+	for (i = 0; i < num; i++)
+		recs[i] = trace->recs[(trace->head + ADF4377_TRACE_SIZE -
+				       trace->count + i) % ADF4377_TRACE_SIZE];
+
+	trace->count -= num;
+
+	return num;
+}
+#endif
+
+/**
+ * @brief Record an SPI transfer in the trace, one record per register.
+ *
+ * The frame is decoded back to register values in ascending address order,
+ * whatever the bit order and streaming direction, so a trace can be replayed
+ * in another interface configuration. The transfer is full duplex and in
+ * place, so the instruction and write data are taken here, before it goes
+ * out, and the read data by adf4377_trace_end().
+ * @param dev - The device structure.
+ * @param buff - The transfer buffer, before the transfer.
+ * @param len - The transfer length in bytes.
+ * @return None.
+ */
+static void adf4377_trace_start(struct adf4377_dev *dev, const uint8_t *buff,
+				uint16_t len)
+{
+#ifdef ADF4377_TRACE
+	struct adf4377_trace *trace = &dev->trace;
+	struct adf4377_trace_rec *rec;
+	uint32_t time_us;
+	uint8_t cmd, reg_addr, num, pos, i;
+
+	time_us = dev->trace_timestamp ? dev->trace_timestamp() : trace->time_us;
+	trace->time_us += DIV_ROUND_UP(len * 8 * 1000000,
+				       dev->spi_desc->max_speed_hz);
+	trace->pending = 0;
+
+	if (len <= ADF4377_SPI_INSTR_BYTES)
+		return;
+
+	if (ADF4377_SPI_LSB_FIRST(dev)) {
+		reg_addr = adf4377_spi_byte(dev, buff[0]);
+		cmd = adf4377_spi_byte(dev, buff[1]);
+	} else {
+		cmd = buff[0];
+		reg_addr = buff[1];
+	}
+
+	num = len - ADF4377_SPI_INSTR_BYTES;
+	if (dev->addr_asc == ADF4377_ADDR_ASC_AUTO_DECR)
+		reg_addr -= num - 1;
+
+	for (i = 0; i < num; i++) {
+		pos = adf4377_spi_burst_pos(dev, num, i);
+		rec = &trace->recs[trace->head];
+		rec->time_us = time_us;
+		rec->reg_addr = reg_addr + i;
+		rec->flags = (cmd & ADF4377_SPI_READ_CMD ? ADF4377_TRACE_READ : 0) |
+			     (i ? ADF4377_TRACE_CONT : 0);
+		rec->data = rec->flags & ADF4377_TRACE_READ ? 0 :
+			    adf4377_spi_byte(dev, buff[pos]);
+		rec->ret = SUCCESS;
+
+		trace->head = (trace->head + 1) % ADF4377_TRACE_SIZE;
+		if (trace->count < ADF4377_TRACE_SIZE)
+			trace->count++;
+		else
+			trace->lost++;
+	}
+
+	trace->pending = num;
+#endif
+}
+
+/**
+ * @brief Complete the trace records of the transfer started last.
+ * @param dev - The device structure.
+ * @param buff - The transfer buffer, after the transfer.
+ * @param ret - The transfer status.
+ * @return None.
+ */
+static void adf4377_trace_end(struct adf4377_dev *dev, const uint8_t *buff,
+			      int32_t ret)
+{
+#ifdef ADF4377_TRACE
+	struct adf4377_trace *trace = &dev->trace;
+	struct adf4377_trace_rec *rec;
+	uint16_t num = trace->pending, idx, i;
+	uint8_t pos;
+
+	/* Only the records still held, in case the transfer wrapped the ring */
+	for (i = num > ADF4377_TRACE_SIZE ? num - ADF4377_TRACE_SIZE : 0;
+	     i < num; i++) {
+		idx = (trace->head + ADF4377_TRACE_SIZE - num + i) % ADF4377_TRACE_SIZE;
+		rec = &trace->recs[idx];
+		rec->ret = ret;
+		if (rec->flags & ADF4377_TRACE_READ) {
+			pos = adf4377_spi_burst_pos(dev, num, i);
+			rec->data = adf4377_spi_byte(dev, buff[pos]);
+		}
+	}
+
+	trace->pending = 0;
+#endif
+}
+
+/**
+ * @brief Account an SPI transfer to the current instrumentation phase.
+ * @param dev - The device structure.
+ * @param len - The transfer length in bytes.
+ * @return None.
+ */
+static void adf4377_stats_xfer(struct adf4377_dev *dev, uint16_t len)
+{
+#ifdef ADF4377_STATS
+	struct adf4377_phase_stats *phase = &dev->stats.phase[dev->phase];
+
+	phase->xfers++;
+	phase->bytes += len;
+	phase->bus_us += DIV_ROUND_UP(len * 8 * 1000000,
+				      dev->spi_desc->max_speed_hz);
+#endif
+}
+
+/**
+ * @brief Run an SPI transfer.
+ * @param dev - The device structure.
+ * @param buff - The transfer buffer.
+ * @param len - The transfer length in bytes.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_spi_xfer(struct adf4377_dev *dev, uint8_t *buff,
+				uint16_t len)
+{
+	bool taken;
+	int32_t ret;
+
+	adf4377_stats_xfer(dev, len);
+
+	ret = adf4377_bus_get(dev, &taken);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_trace_start(dev, buff, len);
+
+	ret = spi_write_and_read(dev->spi_desc, buff, len);
+
+	adf4377_trace_end(dev, buff, ret);
+
+	adf4377_bus_put(dev, taken);
+
+	return ret;
+}
+
+/**
+ * @brief Run a write transfer, or record it while an asynchronous job is
+ * being prepared.
+ *
+ * Reads always go out immediately through adf4377_spi_xfer(), so the shadow
+ * cache lookups made while preparing a job keep working.
+ * @param dev - The device structure.
+ * @param buff - The transfer buffer.
+ * @param len - The transfer length in bytes.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_spi_write_xfer(struct adf4377_dev *dev, uint8_t *buff,
+				      uint16_t len)
+{
+#ifdef ADF4377_ASYNC
+	struct adf4377_async_job *job = &dev->job;
+
+	if (job->recording) {
+		if (job->num_frames == ADF4377_ASYNC_MAX_FRAMES ||
+		    job->len + len > sizeof(job->buff))
+			return -ENOMEM;
+
+		memcpy(&job->buff[job->len], buff, len);
+		job->frame_len[job->num_frames++] = len;
+		job->len += len;
+
+		return SUCCESS;
+	}
+#endif
+
+	return adf4377_spi_xfer(dev, buff, len);
+}
+
+/**
+ * @brief Busy wait.
+ * @param dev - The device structure.
+ * @param us - The delay in us.
+ * @return None.
+ */
+static void adf4377_delay_us(struct adf4377_dev *dev, uint32_t us)
+{
+#ifdef ADF4377_STATS
+	dev->stats.phase[dev->phase].delay_us += us;
+#endif
+#ifdef ADF4377_TRACE
+	dev->trace.time_us += us;
+#endif
+
+	udelay(us);
+}
+
+/**
+ * @brief Note the start of a VCO calibration by a write to N_INT LSB.
+ * @param dev - The device structure.
+ * @param reg_addr - Address of the first (lowest) written register.
+ * @param len - Number of written registers.
+ * @return None.
+ */
+static void adf4377_cal_start(struct adf4377_dev *dev, uint8_t reg_addr,
+			      uint8_t len)
+{
+	if (reg_addr <= ADF4377_REG(0x10) && reg_addr + len > ADF4377_REG(0x10))
+		dev->cal_pending = true;
+}
+
+/**
+ * @brief Writes data to ADF4377 over SPI.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param data - Data value to write.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_spi_write(struct adf4377_dev *dev, uint8_t reg_addr,
+			  uint8_t data)
+{
+	int32_t ret;
+	uint8_t buff[ADF4377_BUFF_SIZE_BYTES];
+
+	ADF4377_STATS_INC(dev, spi_write_calls);
+
+	if (ADF4377_SPI_LSB_FIRST(dev)) {
+		buff[0] = adf4377_spi_byte(dev, reg_addr);
+		buff[1] = adf4377_spi_byte(dev, ADF4377_SPI_WRITE_CMD);
+	} else {
+		buff[0] = ADF4377_SPI_WRITE_CMD;
+		buff[1] = reg_addr;
+	}
+	buff[2] = adf4377_spi_byte(dev, data);
+
+	ret = adf4377_spi_write_xfer(dev, buff, ADF4377_BUFF_SIZE_BYTES);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_cal_start(dev, reg_addr, 1);
+	adf4377_reg_cache(dev, reg_addr, data);
+
+	return ret;
+}
+
+/**
+ * @brief Update ADF4377 register.
+ *
+ * The current register value is taken from the shadow cache when available,
+ * so only the write goes out on the bus.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param mask - Mask for specific register bits to be updated.
+ * @param data - Data read from the device.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_update_unlocked(struct adf4377_dev *dev,
+				       uint8_t reg_addr, uint8_t mask,
+				       uint8_t data)
+{
+	uint8_t read_val;
+	int32_t ret;
+
+	ADF4377_STATS_INC(dev, update_calls);
+
+	if (adf4377_reg_cached(dev, reg_addr)) {
+		read_val = dev->regmap[reg_addr];
+	} else {
+		ret = adf4377_spi_read(dev, reg_addr, &read_val);
+		if (ret != SUCCESS)
+			return ret;
+	}
+
+	read_val &= ~mask;
+	read_val |= data;
+
+	ret = adf4377_spi_write(dev, reg_addr, read_val);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_update_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param mask - Mask for specific register bits to be updated.
+ * @param data - Data read from the device.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_update(struct adf4377_dev *dev, uint8_t reg_addr,
+		       uint8_t mask, uint8_t data)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_update_unlocked(dev, reg_addr, mask, data);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Reads data from ADF4377 over SPI.
+ * @param dev - The device structure.
+ * @param reg_addr - The register address.
+ * @param data - Data read from the device.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_spi_read(struct adf4377_dev *dev, uint8_t reg_addr,
+			 uint8_t *data)
+{
+	int32_t ret;
+	uint8_t buff[ADF4377_BUFF_SIZE_BYTES];
+
+	ADF4377_STATS_INC(dev, spi_read_calls);
+
+	if (ADF4377_SPI_LSB_FIRST(dev)) {
+		buff[0] = adf4377_spi_byte(dev, reg_addr);
+		buff[1] = adf4377_spi_byte(dev, ADF4377_SPI_READ_CMD);
+	} else {
+		buff[0] = ADF4377_SPI_READ_CMD;
+		buff[1] = reg_addr;
+	}
+	buff[2] = ADF4377_SPI_DUMMY_DATA;
+
+	ret = adf4377_spi_xfer(dev, buff, ADF4377_BUFF_SIZE_BYTES);
+	if(ret != SUCCESS)
+		return ret;
+
+	*data = adf4377_spi_byte(dev, buff[2]);
+
+	adf4377_reg_cache(dev, reg_addr, *data);
+
+	return ret;
+}
+
+/**
+ * @brief Prepare the instruction header of a streaming transfer.
+ *
+ * In auto decrement mode the header carries the highest register address of
+ * the block, in auto increment mode the lowest one.
+ * @param dev - The device structure.
+ * @param cmd - ADF4377_SPI_WRITE_CMD or ADF4377_SPI_READ_CMD.
+ * @param reg_addr - Address of the first (lowest) register in the block.
+ * @param len - Number of registers in the block.
+ * @param buff - Transfer buffer.
+ * @return None.
+ */
+static void adf4377_spi_burst_header(struct adf4377_dev *dev, uint8_t cmd,
+				     uint8_t reg_addr, uint8_t len, uint8_t *buff)
+{
+	if (dev->addr_asc == ADF4377_ADDR_ASC_AUTO_DECR)
+		reg_addr += len - 1;
+
+	if (ADF4377_SPI_LSB_FIRST(dev)) {
+		buff[0] = adf4377_spi_byte(dev, reg_addr);
+		buff[1] = adf4377_spi_byte(dev, cmd);
+	} else {
+		buff[0] = cmd;
+		buff[1] = reg_addr;
+	}
+}
+
+/**
+ * @brief Writes a block of consecutive registers in a single SPI transfer.
+ *
+ * One instruction header is followed by all the data bytes, in the address
+ * direction configured through ADDRESS_ASC. With the auto decrement mode used
+ * by the driver the lowest register is written last.
+ * @param dev - The device structure.
+ * @param reg_addr - Address of the first (lowest) register in the block.
+ * @param data - Register values, data[i] is written to reg_addr + i.
+ * @param len - Number of registers to write.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_spi_write_burst(struct adf4377_dev *dev, uint8_t reg_addr,
+				const uint8_t *data, uint8_t len)
+{
+	int32_t ret;
+	uint8_t i, pos;
+	uint8_t buff[ADF4377_BURST_SIZE_BYTES];
+
+	ADF4377_STATS_INC(dev, burst_calls);
+
+	if (!len || reg_addr + len > ADF4377_REGMAP_SIZE)
+		return -EINVAL;
+
+	adf4377_spi_burst_header(dev, ADF4377_SPI_WRITE_CMD, reg_addr, len, buff);
+
+	for (i = 0; i < len; i++) {
+		pos = adf4377_spi_burst_pos(dev, len, i);
+		buff[pos] = adf4377_spi_byte(dev, data[i]);
+	}
+
+	ret = adf4377_spi_write_xfer(dev, buff,
+				     ADF4377_SPI_INSTR_BYTES + len);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_cal_start(dev, reg_addr, len);
+	for (i = 0; i < len; i++)
+		adf4377_reg_cache(dev, reg_addr + i, data[i]);
+
+	return ret;
+}
+
+/**
+ * @brief Reads a block of consecutive registers in a single SPI transfer.
+ * @param dev - The device structure.
+ * @param reg_addr - Address of the first (lowest) register in the block.
+ * @param data - Register values, data[i] is read from reg_addr + i.
+ * @param len - Number of registers to read.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_spi_read_burst(struct adf4377_dev *dev, uint8_t reg_addr,
+			       uint8_t *data, uint8_t len)
+{
+	int32_t ret;
+	uint8_t i, pos;
+	uint8_t buff[ADF4377_BURST_SIZE_BYTES];
+
+	ADF4377_STATS_INC(dev, burst_calls);
+
+	if (!len || reg_addr + len > ADF4377_REGMAP_SIZE)
+		return -EINVAL;
+
+	adf4377_spi_burst_header(dev, ADF4377_SPI_READ_CMD, reg_addr, len, buff);
+	memset(&buff[ADF4377_SPI_INSTR_BYTES], ADF4377_SPI_DUMMY_DATA, len);
+
+	ret = adf4377_spi_xfer(dev, buff,
+				 ADF4377_SPI_INSTR_BYTES + len);
+	if (ret != SUCCESS)
+		return ret;
+
+	for (i = 0; i < len; i++) {
+		pos = adf4377_spi_burst_pos(dev, len, i);
+		data[i] = adf4377_spi_byte(dev, buff[pos]);
+
+		adf4377_reg_cache(dev, reg_addr + i, data[i]);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Get the current values of a block of consecutive registers.
+ *
+ * The values come from the shadow cache, the block is burst read from the
+ * device only if one of the registers is not cached.
+ * @param dev - The device structure.
+ * @param reg_addr - Address of the first (lowest) register in the block.
+ * @param data - Register values, data[i] holds reg_addr + i.
+ * @param len - Number of registers.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_regmap_get_block(struct adf4377_dev *dev,
+					uint8_t reg_addr, uint8_t *data,
+					uint8_t len)
+{
+	uint8_t i;
+
+	for (i = 0; i < len; i++)
+		if (!adf4377_reg_cached(dev, reg_addr + i))
+			return adf4377_spi_read_burst(dev, reg_addr, data, len);
+
+	memcpy(data, &dev->regmap[reg_addr], len);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Initialize a transaction batch.
+ * @param batch - The batch structure.
+ * @param entries - Caller provided storage for the queued entries.
+ * @param size - Number of entries available in the storage.
+ * @return None.
+ */
+void adf4377_batch_init(struct adf4377_batch *batch,
+			struct adf4377_batch_entry *entries, uint8_t size)
+{
+	batch->entries = entries;
+	batch->size = size;
+	batch->count = 0;
+	batch->ret = SUCCESS;
+}
+
+/**
+ * @brief Queue a register update in a transaction batch.
+ *
+ * Entries are kept sorted by address and updates of the same register are
+ * merged. The first error is also kept in the batch and returned by
+ * adf4377_batch_flush(), so a sequence of queue calls can be checked once.
+ * @param batch - The batch structure.
+ * @param reg_addr - The register address.
+ * @param mask - Mask for specific register bits to be updated.
+ * @param data - Data to be written in the masked bits.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_batch_update(struct adf4377_batch *batch, uint8_t reg_addr,
+			     uint8_t mask, uint8_t data)
+{
+	struct adf4377_batch_entry *entry;
+	uint8_t i;
+
+	if (batch->ret != SUCCESS)
+		return batch->ret;
+
+	if (adf4377_reg_volatile(reg_addr)) {
+		batch->ret = -EINVAL;
+		return batch->ret;
+	}
+
+	for (i = 0; i < batch->count; i++)
+		if (batch->entries[i].reg_addr >= reg_addr)
+			break;
+
+	entry = &batch->entries[i];
+	if (i < batch->count && entry->reg_addr == reg_addr) {
+		entry->data = (entry->data & ~mask) | (data & mask);
+		entry->mask |= mask;
+		return SUCCESS;
+	}
+
+	if (batch->count == batch->size) {
+		batch->ret = -ENOMEM;
+		return batch->ret;
+	}
+
+	memmove(entry + 1, entry, (batch->count - i) * sizeof(*entry));
+	entry->reg_addr = reg_addr;
+	entry->mask = mask;
+	entry->data = data & mask;
+	batch->count++;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Queue a register write in a transaction batch.
+ * @param batch - The batch structure.
+ * @param reg_addr - The register address.
+ * @param data - Data value to write.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+int32_t adf4377_batch_write(struct adf4377_batch *batch, uint8_t reg_addr,
+			    uint8_t data)
+{
+	return adf4377_batch_update(batch, reg_addr, 0xFF, data);
+}
+
+/**
+ * @brief Check if a run of batch entries can be extended to a register.
+ *
+ * Small gaps are bridged by rewriting the cached values of the registers in
+ * between, which is cheaper than a new instruction header. N_INT LSB starts a
+ * VCO calibration when written, so it is never rewritten as filler and always
+ * starts a run, which is committed last.
+ * @param dev - The device structure.
+ * @param last - Highest register address already in the run.
+ * @param reg_addr - The next queued register address.
+ * @return Returns true if the register joins the run, false otherwise.
+ */
+static bool adf4377_batch_joins(struct adf4377_dev *dev, uint8_t last,
+				uint8_t reg_addr)
+{
+	uint8_t i;
+
+	if (reg_addr == ADF4377_REG(0x10) ||
+	    reg_addr - last - 1 > ADF4377_BATCH_MAX_GAP)
+		return false;
+
+	if (dev->addr_asc != ADF4377_ADDR_ASC_AUTO_DECR &&
+	    last == ADF4377_REG(0x10))
+		return false;
+
+	for (i = last + 1; i < reg_addr; i++)
+		if (i == ADF4377_REG(0x10) || !adf4377_reg_cached(dev, i))
+			return false;
+
+	return true;
+}
+
+/**
+ * @brief Write a run of batch entries in a single burst transfer.
+ * @param dev - The device structure.
+ * @param batch - The batch structure.
+ * @param first - Index of the first entry of the run.
+ * @param last - Index of the last entry of the run.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_batch_run(struct adf4377_dev *dev,
+				 struct adf4377_batch *batch, uint8_t first,
+				 uint8_t last)
+{
+	struct adf4377_batch_entry *entry;
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	uint8_t reg_addr, len, i;
+	int32_t ret;
+
+	reg_addr = batch->entries[first].reg_addr;
+	len = batch->entries[last].reg_addr - reg_addr + 1;
+
+	ret = adf4377_regmap_get_block(dev, reg_addr, regs, len);
+	if (ret != SUCCESS)
+		return ret;
+
+	for (i = first; i <= last; i++) {
+		entry = &batch->entries[i];
+		regs[entry->reg_addr - reg_addr] &= ~entry->mask;
+		regs[entry->reg_addr - reg_addr] |= entry->data;
+	}
+
+	return adf4377_spi_write_burst(dev, reg_addr, regs, len);
+}
+
+/**
+ * @brief Write all the queued register updates and empty the batch.
+ *
+ * Updates that leave a cached register value unchanged are dropped, except
+ * N_INT LSB which is always written since it starts the VCO calibration.
+ * The remaining registers are grouped in contiguous runs, each sent as one
+ * burst transfer. Runs are committed in the configured address direction,
+ * except the run starting with N_INT LSB, which always goes out last.
+ * @param dev - The device structure.
+ * @param batch - The batch structure.
+ * @return Returns SUCCESS in case of success or negative error code otherwise.
+ */
+static int32_t adf4377_batch_flush_unlocked(struct adf4377_dev *dev,
+					    struct adf4377_batch *batch)
+{
+	uint8_t run_first[ADF4377_REGMAP_SIZE], run_last[ADF4377_REGMAP_SIZE];
+	uint8_t num_runs = 0, trigger_run = 0, count = 0, i, run;
+	struct adf4377_batch_entry *entry;
+	bool has_trigger = false, taken = false;
+	uint8_t val;
+	int32_t ret;
+
+	ret = batch->ret;
+	if (ret != SUCCESS)
+		goto exit;
+
+	for (i = 0; i < batch->count; i++) {
+		entry = &batch->entries[i];
+		if (entry->reg_addr != ADF4377_REG(0x10) &&
+		    adf4377_reg_cached(dev, entry->reg_addr)) {
+			val = dev->regmap[entry->reg_addr];
+			if (((val & ~entry->mask) | entry->data) == val)
+				continue;
+		}
+
+		batch->entries[count++] = *entry;
+	}
+	batch->count = count;
+
+	for (i = 0; i < batch->count; i++) {
+		if (num_runs &&
+		    adf4377_batch_joins(dev, batch->entries[i - 1].reg_addr,
+					batch->entries[i].reg_addr)) {
+			run_last[num_runs - 1] = i;
+			continue;
+		}
+
+		if (batch->entries[i].reg_addr == ADF4377_REG(0x10)) {
+			has_trigger = true;
+			trigger_run = num_runs;
+		}
+
+		run_first[num_runs] = i;
+		run_last[num_runs] = i;
+		num_runs++;
+	}
+
+	/* All the runs go out back to back, other devices wait for the end */
+	if (num_runs > 1) {
+		ret = adf4377_bus_get(dev, &taken);
+		if (ret != SUCCESS)
+			goto exit;
+	}
+
+	for (i = 0; i < num_runs; i++) {
+		if (dev->addr_asc == ADF4377_ADDR_ASC_AUTO_DECR)
+			run = num_runs - 1 - i;
+		else
+			run = i;
+
+		if (has_trigger && run == trigger_run)
+			continue;
+
+		ret = adf4377_batch_run(dev, batch, run_first[run], run_last[run]);
+		if (ret != SUCCESS)
+			goto exit;
+	}
+
+	if (has_trigger) {
+		/* The calibration drops the lock, until the next wait for lock */
+		dev->events_armed = false;
+		ret = adf4377_batch_run(dev, batch, run_first[trigger_run],
+					run_last[trigger_run]);
+	}
+
+exit:
+	adf4377_bus_put(dev, taken);
+	adf4377_batch_init(batch, batch->entries, batch->size);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_batch_flush_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param batch - The batch structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_batch_flush(struct adf4377_dev *dev,
+			    struct adf4377_batch *batch)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_batch_flush_unlocked(dev, batch);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+#ifdef ADF4377_ASYNC
+/**
+ * @brief Start recording the write transfers of an asynchronous job.
+ *
+ * The frames of a job go straight to the non-blocking transport, which owns
+ * the SPI bus until the job completes. The bus lock cannot be released from
+ * the completion interrupt, so jobs are refused on a shared bus.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success, -ENOSYS without a non-blocking
+ * transport or with a bus lock, -EBUSY while another job is in progress.
+ */
+static int32_t adf4377_async_begin(struct adf4377_dev *dev)
+{
+	struct adf4377_async_job *job = &dev->job;
+
+	if (!dev->async_ops || !dev->async_ops->submit || dev->bus_lock)
+		return -ENOSYS;
+
+	if (job->busy)
+		return -EBUSY;
+
+	job->num_frames = 0;
+	job->len = 0;
+	job->frame = 0;
+	job->pos = 0;
+	job->lock_wait = false;
+	job->plan_valid = false;
+	job->recording = true;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Drop a job whose preparation failed.
+ *
+ * The shadow cache already holds the recorded values, it no longer matches
+ * the device.
+ * @param dev - The device structure.
+ * @return None.
+ */
+static void adf4377_async_abort(struct adf4377_dev *dev)
+{
+	dev->job.recording = false;
+	adf4377_regmap_invalidate(dev);
+}
+
+/**
+ * @brief Terminate the current job and report its status.
+ * @param dev - The device structure.
+ * @param status - The job status.
+ * @return None.
+ */
+static void adf4377_async_complete(struct adf4377_dev *dev, int32_t status)
+{
+	struct adf4377_async_job *job = &dev->job;
+
+	if (status != SUCCESS) {
+		adf4377_regmap_invalidate(dev);
+	} else if (job->plan_valid) {
+		dev->plan = job->plan;
+		dev->f_clk = job->plan.f_clk;
+		dev->ref_doubler_en = job->plan.ref_doubler_en;
+		dev->cal_temp_valid = false;
+		dev->events_armed = true;
+	}
+
+	job->busy = false;
+
+	if (job->done)
+		job->done(job->done_ctx, status);
+}
+
+static void adf4377_async_done(void *arg, int32_t status);
+
+/**
+ * @brief Build the lock status read frame of the current job.
+ *
+ * The transfer is full duplex and in place, so the whole frame is rebuilt
+ * before every poll.
+ * @param dev - The device structure.
+ * @return None.
+ */
+static void adf4377_async_poll_frame(struct adf4377_dev *dev)
+{
+	uint8_t *poll = dev->job.poll;
+
+	if (ADF4377_SPI_LSB_FIRST(dev)) {
+		poll[0] = adf4377_spi_byte(dev, ADF4377_REG(0x49));
+		poll[1] = adf4377_spi_byte(dev, ADF4377_SPI_READ_CMD);
+	} else {
+		poll[0] = ADF4377_SPI_READ_CMD;
+		poll[1] = ADF4377_REG(0x49);
+	}
+	poll[ADF4377_SPI_INSTR_BYTES] = ADF4377_SPI_DUMMY_DATA;
+}
+
+/**
+ * @brief Submit the next frame of the current job, or complete it.
+ * @param dev - The device structure.
+ * @return None.
+ */
+static void adf4377_async_next(struct adf4377_dev *dev)
+{
+	struct adf4377_async_job *job = &dev->job;
+	const struct adf4377_async_ops *ops = dev->async_ops;
+	uint8_t *frame;
+	uint16_t len;
+	int32_t ret;
+
+	if (job->lock_wait && job->frame == job->lock_frame) {
+		adf4377_async_poll_frame(dev);
+		frame = job->poll;
+		len = ADF4377_BUFF_SIZE_BYTES;
+	} else if (job->frame < job->num_frames) {
+		frame = &job->buff[job->pos];
+		len = job->frame_len[job->frame];
+	} else {
+		adf4377_async_complete(dev, SUCCESS);
+		return;
+	}
+
+	adf4377_stats_xfer(dev, len);
+	adf4377_trace_start(dev, frame, len);
+
+	ret = ops->submit(ops->ctx, frame, len, adf4377_async_done, dev);
+	if (ret != SUCCESS) {
+		adf4377_trace_end(dev, frame, ret);
+		adf4377_async_complete(dev, ret);
+	}
+}
+
+/**
+ * @brief Timer callback spacing the lock status polls.
+ * @param arg - The device structure.
+ * @return None.
+ */
+static void adf4377_async_poll(void *arg)
+{
+	adf4377_async_next(arg);
+}
+
+/**
+ * @brief Transfer completion of the non-blocking transport.
+ *
+ * While waiting for lock the status register is read every
+ * ADF4377_LOCK_POLL_US through the transport timer, or back to back without
+ * one, until the lock timeout of the plan expires.
+ * @param arg - The device structure.
+ * @param status - The transfer status.
+ * @return None.
+ */
+static void adf4377_async_done(void *arg, int32_t status)
+{
+	struct adf4377_dev *dev = arg;
+	struct adf4377_async_job *job = &dev->job;
+	const struct adf4377_async_ops *ops = dev->async_ops;
+	bool poll = job->lock_wait && job->frame == job->lock_frame;
+	uint8_t data;
+
+	adf4377_trace_end(dev, poll ? job->poll : &job->buff[job->pos], status);
+
+	if (status != SUCCESS) {
+		adf4377_async_complete(dev, status);
+		return;
+	}
+
+	if (poll) {
+		data = adf4377_spi_byte(dev, job->poll[ADF4377_SPI_INSTR_BYTES]);
+		if ((data & ADF4377_LOCKED_MSK) && !(data & ADF4377_FSM_BUSY_MSK)) {
+			job->lock_wait = false;
+		} else if (!--job->lock_polls) {
+			adf4377_async_complete(dev, -ETIMEDOUT);
+			return;
+		} else if (ops->schedule) {
+			status = ops->schedule(ops->ctx, ADF4377_LOCK_POLL_US,
+					       adf4377_async_poll, dev);
+			if (status != SUCCESS)
+				adf4377_async_complete(dev, status);
+			return;
+		}
+	} else {
+		job->pos += job->frame_len[job->frame++];
+	}
+
+	adf4377_async_next(dev);
+}
+
+/**
+ * @brief Send the recorded frames of the current job.
+ * @param dev - The device structure.
+ * @param done - Completion callback, called from the transport completion
+ * 		 interrupt.
+ * @param ctx - Completion callback context.
+ * @return Returns SUCCESS when the job is started or negative error code.
+ */
+static int32_t adf4377_async_start(struct adf4377_dev *dev,
+				   void (*done)(void *ctx, int32_t status),
+				   void *ctx)
+{
+	struct adf4377_async_job *job = &dev->job;
+
+	job->recording = false;
+	job->done = done;
+	job->done_ctx = ctx;
+	job->busy = true;
+
+	adf4377_async_next(dev);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Write all the queued register updates without blocking.
+ *
+ * The runs are prepared as adf4377_batch_flush() would send them and handed
+ * to the non-blocking transport one after the other. Reads of registers
+ * missing from the shadow cache still block while preparing. No other access
+ * to the device is allowed until done() is called.
+ * @param dev - The device structure.
+ * @param batch - The batch structure, empty on return.
+ * @param done - Completion callback, called from the transport completion
+ * 		 interrupt.
+ * @param ctx - Completion callback context.
+ * @return Returns SUCCESS when the job is started or negative error code.
+ */
+static int32_t adf4377_batch_flush_async_unlocked(struct adf4377_dev *dev,
+						  struct adf4377_batch *batch,
+						  void (*done)(void *ctx, int32_t status),
+						  void *ctx)
+{
+	int32_t ret;
+
+	ret = adf4377_async_begin(dev);
+	if (ret != SUCCESS) {
+		adf4377_batch_init(batch, batch->entries, batch->size);
+		return ret;
+	}
+
+	ret = adf4377_batch_flush_unlocked(dev, batch);
+	if (ret != SUCCESS) {
+		adf4377_async_abort(dev);
+		return ret;
+	}
+
+	return adf4377_async_start(dev, done, ctx);
+}
+
+/**
+ * @brief adf4377_batch_flush_async_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param batch - The batch structure, empty on return.
+ * @param done - Completion callback.
+ * @param ctx - Completion callback context.
+ * @return SUCCESS when the job is started, negative error code otherwise.
+ */
+int32_t adf4377_batch_flush_async(struct adf4377_dev *dev,
+				  struct adf4377_batch *batch,
+				  void (*done)(void *ctx, int32_t status),
+				  void *ctx)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_batch_flush_async_unlocked(dev, batch, done, ctx);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+#endif
+
+/**
+ * @brief ADF4377 SPI Scratchpad check.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+int32_t adf4377_check_scratchpad(struct adf4377_dev *dev)
+{
+	int32_t ret;
+	uint8_t scratchpad;
+
+	ret = adf4377_spi_write(dev, ADF4377_REG(0x0A), ADF4377_SPI_SCRATCHPAD);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_spi_read(dev, ADF4377_REG(0x0A), &scratchpad);
+	if (ret != SUCCESS)
+		return ret;
+
+	if(scratchpad != ADF4377_SPI_SCRATCHPAD)
+		return FAILURE;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Set default registers.
+ * @param dev - The device structure.
+ * @param batch - The batch to queue the register updates in.
+ * @return None.
+ */
+static void adf4377_set_default(struct adf4377_dev *dev,
+				struct adf4377_batch *batch)
+{
+	const struct adf4377_chip_info *info = ADF4377_CHIP_INFO(dev);
+	uint8_t i;
+
+	for (i = 0; i < info->num_defaults; i++)
+		adf4377_batch_update(batch, info->defaults[i].reg_addr,
+				     info->defaults[i].mask, info->defaults[i].data);
+}
+
+/**
+ * @brief Start the software reset of the device.
+ *
+ * The reset completion is checked with adf4377_soft_reset_poll(), which is
+ * allowed to be called for the configured time budget.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_soft_reset_start_unlocked(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_RESET);
+
+	dev->events_armed = false;
+
+	ret = adf4377_update_unlocked(dev, ADF4377_REG(0x00),
+				      ADF4377_SOFT_RESET_MSK | ADF4377_SOFT_RESET_R_MSK,
+				      ADF4377_SOFT_RESET(ADF4377_SOFT_RESET_EN) | ADF4377_SOFT_RESET_R(
+					      ADF4377_SOFT_RESET_EN));
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->reset_polls = DIV_ROUND_UP(dev->reset_timeout_us, dev->reset_poll_us);
+	if (!dev->reset_polls)
+		dev->reset_polls = 1;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_soft_reset_start_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_soft_reset_start(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_soft_reset_start_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Check once whether the software reset is complete.
+ *
+ * No delay is inserted, the caller is expected to call again after the
+ * configured poll interval while -EAGAIN is returned.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS when the reset is complete, -EAGAIN while still in
+ * progress, -ETIMEDOUT when the time budget is exhausted or no reset was
+ * started, or another negative error code.
+ */
+static int32_t adf4377_soft_reset_poll_unlocked(struct adf4377_dev *dev)
+{
+	int32_t ret;
+	uint8_t data;
+
+	if (!dev->reset_polls)
+		return -ETIMEDOUT;
+
+	ret = adf4377_spi_read(dev, ADF4377_REG(0x00), &data);
+	if (ret != SUCCESS)
+		return ret;
+
+	if (!(data & ADF4377_SOFT_RESET(ADF4377_SOFT_RESET_EN))) {
+		/* All registers are back to their reset values */
+		adf4377_regmap_invalidate(dev);
+		adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+		dev->reset_polls = 0;
+		return SUCCESS;
+	}
+
+	dev->reset_polls--;
+
+	return dev->reset_polls ? -EAGAIN : -ETIMEDOUT;
+}
+
+/**
+ * @brief adf4377_soft_reset_poll_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS when the reset is complete, -EAGAIN while still in
+ * progress, or another negative error code.
+ */
+int32_t adf4377_soft_reset_poll(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_soft_reset_poll_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Software reset the device and wait for its completion.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_soft_reset_unlocked(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_soft_reset_start_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	while ((ret = adf4377_soft_reset_poll_unlocked(dev)) == -EAGAIN)
+		adf4377_delay_us(dev, dev->reset_poll_us);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_soft_reset_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_soft_reset(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_soft_reset_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Get the PLL lock status.
+ *
+ * The LKDET GPIO is sampled when available, otherwise the LOCKED and FSM_BUSY
+ * bits of REG0x49 are read. After an N_INT LSB write the pin may still show
+ * the lock of the previous frequency, so REG0x49 is read until FSM_BUSY
+ * reports the calibration done, the pin being trusted from then on.
+ * @param dev - The device structure.
+ * @param locked - Set to true when the PLL is locked and the calibration done.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_get_lock_unlocked(struct adf4377_dev *dev, bool *locked)
+{
+	int32_t ret;
+	uint8_t data;
+
+	if (dev->gpio_lkdet && !dev->cal_pending) {
+		ret = gpio_get_value(dev->gpio_lkdet, &data);
+		if (ret != SUCCESS)
+			return ret;
+
+		*locked = (data == GPIO_HIGH);
+
+		return SUCCESS;
+	}
+
+	ret = adf4377_spi_read(dev, ADF4377_REG(0x49), &data);
+	if (ret != SUCCESS)
+		return ret;
+
+	if (!(data & ADF4377_FSM_BUSY_MSK))
+		dev->cal_pending = false;
+
+	*locked = (data & ADF4377_LOCKED_MSK) && !(data & ADF4377_FSM_BUSY_MSK);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_get_lock_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param locked - Set to true when the PLL is locked and the calibration done.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_lock(struct adf4377_dev *dev, bool *locked)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_get_lock_unlocked(dev, locked);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Lock and reference loss interrupt handler.
+ *
+ * To be registered, with the device structure as context, as the callback of
+ * the LKDET pin interrupt and of the MUXOUT pin interrupt when MUXOUT reports
+ * the lock or reference status. Only the pin levels are read, the SPI bus is
+ * not accessed. Events are reported once while the device is locked and not
+ * reprogrammed, the next completed wait for lock arms them again.
+ * @param ctx - The device structure.
+ * @param event - Interrupt event, unused.
+ * @param extra - Platform specific interrupt data, unused.
+ * @return None.
+ */
+void adf4377_irq_handler(void *ctx, uint32_t event, void *extra)
+{
+	struct adf4377_dev *dev = ctx;
+	uint32_t events = 0;
+	uint8_t val;
+
+	if (!dev->events_armed || !dev->event_cb)
+		return;
+
+	if (dev->gpio_lkdet &&
+	    gpio_get_value(dev->gpio_lkdet, &val) == SUCCESS && val == GPIO_LOW)
+		events |= ADF4377_EVENT_LOCK_LOST;
+
+	if (dev->gpio_muxout &&
+	    gpio_get_value(dev->gpio_muxout, &val) == SUCCESS && val == GPIO_LOW) {
+		if (dev->muxout_default == ADF4377_MUXOUT_LKDET)
+			events |= ADF4377_EVENT_LOCK_LOST;
+		else if (dev->muxout_default == ADF4377_MUXOUT_REF_OK)
+			events |= ADF4377_EVENT_REF_LOST;
+	}
+
+	if (!events)
+		return;
+
+	dev->events_armed = false;
+	dev->event_cb(dev->event_ctx, events);
+}
+
+/**
+ * @brief Get the time spent in one lock status poll.
+ * @param dev - The device structure.
+ * @return The poll interval including the status read, in us.
+ */
+static uint32_t adf4377_lock_poll_us(struct adf4377_dev *dev)
+{
+	uint32_t poll_us = ADF4377_LOCK_POLL_US;
+
+	if (!dev->gpio_lkdet)
+		poll_us += DIV_ROUND_UP(ADF4377_BUFF_SIZE_BYTES * 8 * 1000000,
+					dev->spi_desc->max_speed_hz);
+
+	return poll_us;
+}
+
+/**
+ * @brief Wait for the PLL to lock after a VCO calibration was started.
+ *
+ * Returns as soon as lock is reported and stores the lock time, measured in
+ * poll intervals including the status read, in dev->lock_time_us.
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success, -ETIMEDOUT if the PLL did not
+ * 	   lock within the budget of the active frequency plan or negative
+ * 	   error code otherwise.
+ */
+static int32_t adf4377_wait_lock_unlocked(struct adf4377_dev *dev)
+{
+	int32_t ret;
+	bool locked;
+	uint32_t elapsed = 0, poll_us = adf4377_lock_poll_us(dev);
+
+	adf4377_set_phase(dev, ADF4377_PHASE_LOCK);
+
+	while (true) {
+		ret = adf4377_get_lock_unlocked(dev, &locked);
+		if (ret != SUCCESS)
+			break;
+
+		if (locked) {
+			dev->lock_time_us = elapsed;
+			adf4377_stats_lock(dev, elapsed);
+			dev->events_armed = true;
+			break;
+		}
+
+		if (elapsed >= dev->plan.lock_timeout_us) {
+			ret = -ETIMEDOUT;
+			break;
+		}
+
+		adf4377_delay_us(dev, ADF4377_LOCK_POLL_US);
+		elapsed += poll_us;
+	}
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_wait_lock_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_wait_lock(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_wait_lock_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Compute the reciprocal of a PFD frequency.
+ * @param f_pfd - PFD frequency, ADF4377_MIN_FREQ_PFD or higher.
+ * @return The reciprocal scaled by 2^ADF4377_PFD_RECIP_SHIFT, rounded down.
+ */
+static uint32_t adf4377_pfd_recip(uint32_t f_pfd)
+{
+	return (1ull << ADF4377_PFD_RECIP_SHIFT) / f_pfd;
+}
+
+/**
+ * @brief Compute the output and feedback dividers of a frequency plan.
+ *
+ * N is the output frequency times the rounded down PFD reciprocal, which is
+ * below the exact quotient by at most one for output frequencies under
+ * 2^ADF4377_PFD_RECIP_SHIFT, fixed by a remainder check. Only multiplies,
+ * shifts and compares are left, with no 64-bit division.
+ * @param plan - The frequency plan, with the PFD and output frequencies
+ * 		 filled in.
+ * @param recip - Reciprocal of the PFD frequency, from adf4377_pfd_recip().
+ * @return None.
+ */
+static void adf4377_plan_output(struct adf4377_freq_plan *plan, uint32_t recip)
+{
+	uint64_t n_int;
+
+	plan->clkout_div_sel = 0;
+	plan->f_vco = plan->f_clk;
+
+	while (plan->f_vco < ADF4377_MIN_VCO_FREQ) {
+		plan->f_vco <<= 1;
+		plan->clkout_div_sel++;
+	}
+
+	n_int = (plan->f_clk * recip) >> ADF4377_PFD_RECIP_SHIFT;
+	if (plan->f_clk - n_int * plan->f_pfd >= plan->f_pfd)
+		n_int++;
+
+	plan->n_int = n_int;
+}
+
+/**
+ * @brief Derive the calibration clock and the dividers of a frequency plan.
+ * @param plan - The frequency plan, with the reference, doubler, reference
+ * 		 divider, PFD and output frequencies filled in.
+ * @return None.
+ */
+static void adf4377_plan_dividers(struct adf4377_freq_plan *plan)
+{
+	const struct adf4377_dclk_step *step = adf4377_dclk_steps;
+	uint32_t f_div_rclk;
+
+	while (step < &adf4377_dclk_steps[ARRAY_SIZE(adf4377_dclk_steps) - 1] &&
+	       plan->f_pfd > step->max_f_pfd)
+		step++;
+
+	plan->dclk_div1 = step->dclk_div1;
+	plan->dclk_div2 = step->dclk_div2;
+	plan->dclk_mode = step->dclk_mode;
+	f_div_rclk = plan->f_pfd >> step->div_shift;
+
+	plan->f_div_rclk = f_div_rclk;
+	plan->synth_lock_timeout = DIV_ROUND_UP(f_div_rclk, 50000);
+	plan->vco_alc_timeout = DIV_ROUND_UP(f_div_rclk, 20000);
+	plan->vco_band_div = DIV_ROUND_UP(f_div_rclk,
+					  150000 * 16 * (1 << plan->dclk_mode));
+	plan->adc_clk_div = DIV_ROUND_UP((f_div_rclk / 400000 - 2), 4);
+
+	/* Every calibration step is bounded by the programmed timeouts */
+	plan->lock_timeout_us = DIV_ROUND_UP((uint64_t)(plan->synth_lock_timeout +
+					     plan->vco_alc_timeout) * ADF4377_CAL_MAX_STEPS * 1000000,
+					     f_div_rclk);
+	if (plan->lock_timeout_us < ADF4377_LOCK_TIMEOUT_MIN_US)
+		plan->lock_timeout_us = ADF4377_LOCK_TIMEOUT_MIN_US;
+
+	adf4377_plan_output(plan, adf4377_pfd_recip(plan->f_pfd));
+}
+
+/**
+ * @brief Compute the frequency plan for a reference and output frequency.
+ *
+ * Pure computation without any device access, so plans can also be computed
+ * offline and passed to the driver through init_param->freq_plans.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param ref_doubler_en - Reference doubler enable.
+ * @param f_clk - Output frequency.
+ * @param plan - The computed frequency plan.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_compute_plan(uint32_t clkin_freq, uint8_t ref_doubler_en,
+			     uint64_t f_clk, struct adf4377_freq_plan *plan)
+{
+	if(ADF4377_CHECK_RANGE(f_clk, CLKPN_FREQ))
+		return FAILURE;
+
+	plan->clkin_freq = clkin_freq;
+	plan->ref_doubler_en = ref_doubler_en;
+	plan->f_clk = f_clk;
+	plan->ref_div_factor = 0;
+	plan->tuned = false;
+
+	/*Compute PFD */
+	if (!ref_doubler_en)
+		do {
+			plan->ref_div_factor++;
+			plan->f_pfd = clkin_freq / plan->ref_div_factor;
+		} while (plan->f_pfd > ADF4377_MAX_FREQ_PFD);
+	else
+		plan->f_pfd = clkin_freq * (1 + ref_doubler_en);
+
+	if(ADF4377_CHECK_RANGE(plan->f_pfd, FREQ_PFD))
+		return FAILURE;
+
+	adf4377_plan_dividers(plan);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Compare two frequency plans for the same output frequency.
+ *
+ * The highest PFD frequency wins: it gives the lowest N, so the widest loop
+ * bandwidth and the fastest settling for a given loop filter. The DCLK
+ * bracket scales the calibration clocks and timeouts with the PFD frequency,
+ * leaving the calibration time about the same for every candidate, so it does
+ * not take part in the ranking. Ties go to the plan without the reference
+ * doubler.
+ * @param a - The candidate plan.
+ * @param b - The best plan so far.
+ * @return true if a is better than b, false otherwise.
+ */
+static bool adf4377_plan_better(const struct adf4377_freq_plan *a,
+				const struct adf4377_freq_plan *b)
+{
+	if (a->f_pfd != b->f_pfd)
+		return a->f_pfd > b->f_pfd;
+
+	return a->ref_doubler_en < b->ref_doubler_en;
+}
+
+/**
+ * @brief Compute the fastest settling frequency plan.
+ *
+ * All the doubler and reference divider settings are enumerated, keeping
+ * those with a PFD frequency in range that is an exact divisor of the output
+ * frequency with N in range, ranked by adf4377_plan_better(). The output
+ * divider follows from the VCO range.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param f_clk - Output frequency.
+ * @param plan - The best frequency plan.
+ * @return SUCCESS in case of success, FAILURE if the output frequency is out
+ * of range, -ERANGE if no setting reaches it exactly.
+ */
+int32_t adf4377_solve_plan(uint32_t clkin_freq, uint64_t f_clk,
+			   struct adf4377_freq_plan *plan)
+{
+	struct adf4377_freq_plan cand;
+	bool found = false;
+	uint64_t f_ref;
+	uint8_t dbl, r;
+
+	if(ADF4377_CHECK_RANGE(f_clk, CLKPN_FREQ))
+		return FAILURE;
+
+	for (dbl = ADF4377_REF_DBLR_DIS; dbl <= ADF4377_REF_DBLR_EN; dbl++) {
+		f_ref = (uint64_t)clkin_freq * (1 + dbl);
+
+		for (r = 1; r <= ADF4378_MAX_R_DIV; r++) {
+			if (f_ref % r || f_ref / r > ADF4377_MAX_FREQ_PFD)
+				continue;
+
+			if (f_ref / r < ADF4377_MIN_FREQ_PFD)
+				break;
+
+			if (f_clk % (f_ref / r) || f_clk / (f_ref / r) > ADF4377_N_INT_MAX)
+				continue;
+
+			cand.clkin_freq = clkin_freq;
+			cand.ref_doubler_en = dbl;
+			cand.f_clk = f_clk;
+			cand.ref_div_factor = r;
+			cand.f_pfd = f_ref / r;
+			cand.tuned = false;
+			adf4377_plan_dividers(&cand);
+
+			if (!found || adf4377_plan_better(&cand, plan)) {
+				*plan = cand;
+				found = true;
+			}
+		}
+	}
+
+	return found ? SUCCESS : -ERANGE;
+}
+
+/**
+ * @brief Find a frequency plan in a table of precomputed plans.
+ * @param plans - Table of frequency plans.
+ * @param num_plans - Number of plans in the table.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param ref_doubler_en - Reference doubler enable.
+ * @param f_clk - Output frequency.
+ * @return Returns the matching plan or NULL if the table holds none.
+ */
+const struct adf4377_freq_plan *adf4377_find_plan(
+	const struct adf4377_freq_plan *plans, uint8_t num_plans,
+	uint32_t clkin_freq, uint8_t ref_doubler_en, uint64_t f_clk)
+{
+	uint8_t i;
+
+	for (i = 0; i < num_plans; i++)
+		if (plans[i].f_clk == f_clk && plans[i].clkin_freq == clkin_freq &&
+		    plans[i].ref_doubler_en == ref_doubler_en)
+			return &plans[i];
+
+	return NULL;
+}
+
+/**
+ * @brief Compute a frequency plan at the reference of the last computed one.
+ *
+ * The PFD dependent dividers and timeouts are taken from dev->pfd_plan, only
+ * the output and feedback dividers are computed, in a fixed number of steps
+ * and without division.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @param plan - The frequency plan.
+ * @return SUCCESS in case of success, FAILURE if the output frequency is out
+ * of range.
+ */
+static int32_t adf4377_retune_plan(struct adf4377_dev *dev, uint64_t f_clk,
+				   struct adf4377_freq_plan *plan)
+{
+	if(ADF4377_CHECK_RANGE(f_clk, CLKPN_FREQ))
+		return FAILURE;
+
+	*plan = dev->pfd_plan;
+	plan->f_clk = f_clk;
+	adf4377_plan_output(plan, dev->pfd_recip);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get a frequency plan, from the precomputed plans if available.
+ * @param dev - The device structure.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param ref_doubler_en - Reference doubler enable.
+ * @param f_clk - Output frequency.
+ * @param plan - The frequency plan.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_get_plan(struct adf4377_dev *dev, uint32_t clkin_freq,
+				uint8_t ref_doubler_en, uint64_t f_clk,
+				struct adf4377_freq_plan *plan)
+{
+	const struct adf4377_chip_info *info = ADF4377_CHIP_INFO(dev);
+	const struct adf4377_freq_plan *found;
+	int32_t ret = SUCCESS;
+
+	if (f_clk < info->min_freq || f_clk > info->max_freq)
+		return -EINVAL;
+
+	found = adf4377_find_plan(dev->freq_plans, dev->num_freq_plans,
+				  clkin_freq, ref_doubler_en, f_clk);
+	if (found) {
+		*plan = *found;
+	} else if (dev->solve_plan) {
+		ret = adf4377_solve_plan(clkin_freq, f_clk, plan);
+	} else if (dev->pfd_plan.f_pfd && dev->pfd_plan.clkin_freq == clkin_freq &&
+		   dev->pfd_plan.ref_doubler_en == ref_doubler_en) {
+		ret = adf4377_retune_plan(dev, f_clk, plan);
+	} else {
+		ret = adf4377_compute_plan(clkin_freq, ref_doubler_en, f_clk,
+					   plan);
+		if (ret == SUCCESS) {
+			dev->pfd_plan = *plan;
+			dev->pfd_recip = adf4377_pfd_recip(plan->f_pfd);
+		}
+	}
+	if (ret != SUCCESS)
+		return ret;
+
+	/* Untuned plans run with the init_param loop settings */
+	if (!plan->tuned) {
+		plan->cp_i = dev->cp_i;
+		plan->bleed_en = ADF4377_BLEED_CURR_DIS;
+		plan->bleed_pol = ADF4377_CURRENT_SINK;
+		plan->bleed_i = 0;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Queue the calibration timeouts of a plan.
+ * @param batch - The batch to queue the register updates in.
+ * @param plan - The frequency plan.
+ * @return None.
+ */
+static void adf4377_queue_timeouts(struct adf4377_batch *batch,
+				   const struct adf4377_freq_plan *plan)
+{
+	adf4377_batch_write(batch, ADF4377_REG(0x27),
+			    ADF4377_SYNTH_LOCK_TO_LSB(plan->synth_lock_timeout));
+	adf4377_batch_update(batch, ADF4377_REG(0x28), ADF4377_SYNTH_LOCK_TO_MSB_MSK,
+			     ADF4377_SYNTH_LOCK_TO_MSB(plan->synth_lock_timeout >> 8));
+	adf4377_batch_write(batch, ADF4377_REG(0x29),
+			    ADF4377_VCO_ALC_TO_LSB(plan->vco_alc_timeout));
+	adf4377_batch_update(batch, ADF4377_REG(0x2A), ADF4377_VCO_ALC_TO_MSB_MSK,
+			     ADF4377_VCO_ALC_TO_MSB(plan->vco_alc_timeout >> 8));
+}
+
+/**
+ * @brief Queue the PFD dependent dividers and calibration timeouts.
+ * @param batch - The batch to queue the register updates in.
+ * @param plan - The frequency plan.
+ * @return None.
+ */
+static void adf4377_set_pfd(struct adf4377_batch *batch,
+			    const struct adf4377_freq_plan *plan)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x11),
+			     ADF4377_EN_AUTOCAL_MSK | ADF4377_DCLK_DIV2_MSK,
+			     ADF4377_EN_AUTOCAL(ADF4377_VCO_CALIB_EN) | ADF4377_DCLK_DIV2(plan->dclk_div2));
+	adf4377_batch_update(batch, ADF4377_REG(0x2E),
+			     ADF4377_EN_ADC_CNV_MSK | ADF4377_EN_ADC_MSK | ADF4377_ADC_A_CONV_MSK,
+			     ADF4377_EN_ADC_CNV(ADF4377_EN_ADC_CNV_EN) | ADF4377_EN_ADC(
+				     ADF4377_EN_ADC_EN) | ADF4377_ADC_A_CONV(ADF4377_ADC_A_CONV_VCO_CALIB));
+	adf4377_batch_update(batch, ADF4377_REG(0x2F), ADF4377_DCLK_DIV1_MSK,
+			     ADF4377_DCLK_DIV1(plan->dclk_div1));
+	adf4377_batch_update(batch, ADF4377_REG(0x24), ADF4377_DCLK_MODE_MSK,
+			     ADF4377_DCLK_MODE(plan->dclk_mode));
+	adf4377_queue_timeouts(batch, plan);
+	adf4377_batch_write(batch, ADF4377_REG(0x26),
+			    ADF4377_VCO_BAND_DIV(plan->vco_band_div));
+	adf4377_batch_write(batch, ADF4377_REG(0x2D),
+			    ADF4377_ADC_CLK_DIV(plan->adc_clk_div));
+}
+
+/**
+ * @brief Queue the double buffer enables of the retune registers.
+ *
+ * With the double buffers enabled, the output divider, the calibration clock
+ * dividers and the VCO overrides are only loaded by the N_INT LSB write, so a
+ * retune is applied in one step whatever the order of the other writes.
+ * @param batch - The batch to queue the register updates in.
+ * @param enable - true to enable the double buffers, false to disable them.
+ * @return None.
+ */
+static void adf4377_queue_double_buffer(struct adf4377_batch *batch,
+					bool enable)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x25),
+			     ADF4377_CLKODIV_DB_MSK | ADF4377_DCLK_DB_MSK,
+			     ADF4377_CLKODIV_DB(enable) | ADF4377_DCLK_DB(enable));
+	adf4377_batch_update(batch, ADF4377_REG(0x28), ADF4377_O_VCO_DB_MSK,
+			     ADF4377_O_VCO_DB(enable));
+}
+
+/**
+ * @brief Queue the feedback, reference and output dividers of a plan.
+ * @param batch - The batch to queue the register updates in.
+ * @param plan - The frequency plan.
+ * @return None.
+ */
+static void adf4377_queue_freq(struct adf4377_batch *batch,
+			       const struct adf4377_freq_plan *plan)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x11),
+			     ADF4377_EN_RDBLR_MSK | ADF4377_N_INT_MSB_MSK,
+			     ADF4377_EN_RDBLR(plan->ref_doubler_en) | ADF4377_N_INT_MSB(plan->n_int >> 8));
+	adf4377_batch_update(batch, ADF4377_REG(0x12),
+			     ADF4377_R_DIV_MSK | ADF4377_CLKOUT_DIV_MSK,
+			     ADF4377_CLKOUT_DIV(plan->clkout_div_sel) | ADF4377_R_DIV(plan->ref_div_factor));
+	adf4377_batch_write(batch, ADF4377_REG(0x10), ADF4377_N_INT_LSB(plan->n_int));
+}
+
+/**
+ * @brief Queue the loop settings and calibration timeouts of a plan.
+ *
+ * Only needed when retuning to or from a tuned plan, untuned plans otherwise
+ * run with the settings programmed by the setup.
+ * @param dev - The device structure.
+ * @param batch - The batch to queue the register updates in.
+ * @param plan - The frequency plan.
+ * @return None.
+ */
+static void adf4377_queue_loop(struct adf4377_dev *dev,
+			       struct adf4377_batch *batch,
+			       const struct adf4377_freq_plan *plan)
+{
+	if (!plan->tuned && !dev->plan.tuned)
+		return;
+
+	adf4377_batch_update(batch, ADF4377_REG(0x15),
+			     ADF4377_BLEED_I_LSB_MSK | ADF4377_BLEED_POL_MSK |
+			     ADF4377_EN_BLEED_MSK | ADF4377_CP_I_MSK,
+			     ADF4377_BLEED_I_LSB(plan->bleed_i) | ADF4377_BLEED_POL(plan->bleed_pol) |
+			     ADF4377_EN_BLEED(plan->bleed_en) | ADF4377_CP_I(plan->cp_i));
+	if (plan->bleed_en)
+		adf4377_batch_write(batch, ADF4377_REG(0x16),
+				    ADF4377_BLEED_I_MSB(plan->bleed_i >> 2));
+
+	adf4377_queue_timeouts(batch, plan);
+}
+
+/**
+ * @brief Program the dividers of a frequency plan and start the VCO
+ * calibration, without waiting for lock.
+ *
+ * The PFD dependent dividers and timeouts are reprogrammed as well when the
+ * plan moves to another PFD frequency.
+ * @param dev - The device structure.
+ * @param plan - The frequency plan.
+ * @param batch - The batch holding pending updates, flushed before return.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_start_freq(struct adf4377_dev *dev,
+				  const struct adf4377_freq_plan *plan,
+				  struct adf4377_batch *batch)
+{
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	if (plan->f_pfd != dev->plan.f_pfd)
+		adf4377_set_pfd(batch, plan);
+	adf4377_queue_loop(dev, batch, plan);
+	adf4377_queue_freq(batch, plan);
+
+	/* N_INT LSB is committed last and starts the calibration */
+	ret = adf4377_batch_flush_unlocked(dev, batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->plan = *plan;
+	dev->f_clk = plan->f_clk;
+	dev->ref_doubler_en = plan->ref_doubler_en;
+	dev->cal_temp_valid = false;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Program the dividers of a frequency plan and wait for lock.
+ * @param dev - The device structure.
+ * @param plan - The frequency plan.
+ * @param batch - The batch holding pending updates, flushed before return.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_freq(struct adf4377_dev *dev,
+				const struct adf4377_freq_plan *plan,
+				struct adf4377_batch *batch)
+{
+	int32_t ret;
+
+	ret = adf4377_start_freq(dev, plan, batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_wait_lock_unlocked(dev);
+}
+
+/**
+ * @brief Enable or disable the clocks used by the VCO calibration.
+ * @param batch - The batch to queue the register updates in.
+ * @param enable - true to enable the clocks, false to disable them.
+ * @return None.
+ */
+static void adf4377_cal_clocks(struct adf4377_batch *batch, bool enable)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x1C),
+			     ADF4377_EN_DNCLK_MSK | ADF4377_EN_DRCLK_MSK,
+			     ADF4377_EN_DNCLK(enable) | ADF4377_EN_DRCLK(enable));
+	adf4377_batch_update(batch, ADF4377_REG(0x20), ADF4377_EN_ADC_CLK_MSK,
+			     ADF4377_EN_ADC_CLK(enable));
+}
+
+/**
+ * @brief Program the dividers of a frequency plan and run a VCO calibration.
+ *
+ * The calibration clocks are only enabled for the duration of the
+ * calibration. On return the batch holds the updates disabling them, to be
+ * flushed by the caller together with its own updates.
+ * @param dev - The device structure.
+ * @param plan - The frequency plan.
+ * @param batch - Batch with pending register updates.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_calibrate(struct adf4377_dev *dev,
+				 const struct adf4377_freq_plan *plan,
+				 struct adf4377_batch *batch)
+{
+	int32_t ret;
+
+	adf4377_cal_clocks(batch, true);
+
+	ret = adf4377_set_freq(dev, plan, batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	if (!dev->hop_mode)
+		adf4377_cal_clocks(batch, false);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Leave the fast hopping mode and return to full VCO calibrations.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_hop_exit_unlocked(struct adf4377_dev *dev)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[3];
+
+	if (!dev->hop_mode)
+		return SUCCESS;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_batch_update(&batch, ADF4377_REG(0x3D),
+			     ADF4377_O_VCO_BAND_MSK | ADF4377_O_VCO_CORE_MSK,
+			     ADF4377_O_VCO_BAND(ADF4377_O_VCO_BAND_VCO_CALIB) |
+			     ADF4377_O_VCO_CORE(ADF4377_O_VCO_CORE_VCO_CALIB));
+	adf4377_cal_clocks(&batch, false);
+
+	dev->hop_mode = false;
+
+	return adf4377_batch_flush_unlocked(dev, &batch);
+}
+
+/**
+ * @brief adf4377_hop_exit_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_hop_exit(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Calibrate a list of output frequencies for fast hopping.
+ *
+ * Every frequency goes through a full VCO calibration once and the VCO core
+ * and band selected by the calibration are stored in the hop table. The
+ * device is left tuned to the last frequency of the list.
+ * @param dev - The device structure.
+ * @param freqs - Output frequencies.
+ * @param table - Hop table, one entry per frequency.
+ * @param num - Number of frequencies.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_hop_table_calibrate_unlocked(struct adf4377_dev *dev,
+						    const uint64_t *freqs,
+						    struct adf4377_hop_entry *table,
+						    uint8_t num)
+{
+	/* VCO_CORE readback up to VCO_BAND readback */
+	uint8_t regs[ADF4377_REG(0x4F) - ADF4377_REG(0x4B) + 1];
+	struct adf4377_freq_plan plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	int32_t ret;
+	uint8_t i;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	for (i = 0; i < num; i++) {
+		ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en,
+				       freqs[i], &plan);
+		if (ret != SUCCESS)
+			return ret;
+
+		ret = adf4377_calibrate(dev, &plan, &batch);
+		if (ret != SUCCESS)
+			return ret;
+
+		ret = adf4377_batch_flush_unlocked(dev, &batch);
+		if (ret != SUCCESS)
+			return ret;
+
+		ret = adf4377_spi_read_burst(dev, ADF4377_REG(0x4B), regs,
+					     ARRAY_SIZE(regs));
+		if (ret != SUCCESS)
+			return ret;
+
+		table[i].f_clk = plan.f_clk;
+		table[i].n_int = plan.n_int;
+		table[i].clkout_div_sel = plan.clkout_div_sel;
+		table[i].vco_core = field_get(ADF4377_VCO_CORE_MSK, regs[0]);
+		table[i].vco_band = field_get(ADF4377_VCO_BAND_MSK,
+					      regs[ARRAY_SIZE(regs) - 1]);
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_hop_table_calibrate_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param freqs - Output frequencies.
+ * @param table - Hop table, one entry per frequency.
+ * @param num - Number of frequencies.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_hop_table_calibrate(struct adf4377_dev *dev,
+				    const uint64_t *freqs,
+				    struct adf4377_hop_entry *table, uint8_t num)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_table_calibrate_unlocked(dev, freqs, table, num);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Queue the dividers and VCO selection of a hop table entry.
+ * @param batch - The batch to queue the register updates in.
+ * @param entry - Hop table entry.
+ * @return None.
+ */
+static void adf4377_queue_hop(struct adf4377_batch *batch,
+			      const struct adf4377_hop_entry *entry)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x13), ADF4377_M_VCO_CORE_MSK,
+			     ADF4377_M_VCO_CORE(entry->vco_core));
+	adf4377_batch_write(batch, ADF4377_REG(0x14),
+			    ADF4377_M_VCO_BAND(entry->vco_band));
+	adf4377_batch_update(batch, ADF4377_REG(0x12), ADF4377_CLKOUT_DIV_MSK,
+			     ADF4377_CLKOUT_DIV(entry->clkout_div_sel));
+	adf4377_batch_update(batch, ADF4377_REG(0x11), ADF4377_N_INT_MSB_MSK,
+			     ADF4377_N_INT_MSB(entry->n_int >> 8));
+	adf4377_batch_write(batch, ADF4377_REG(0x10),
+			    ADF4377_N_INT_LSB(entry->n_int));
+}
+
+/**
+ * @brief Record a hop table entry as the current frequency.
+ * @param dev - The device structure.
+ * @param entry - Hop table entry.
+ * @return None.
+ */
+static void adf4377_hop_commit(struct adf4377_dev *dev,
+			       const struct adf4377_hop_entry *entry)
+{
+	dev->hop_mode = true;
+	dev->cal_temp_valid = false;
+	dev->f_clk = entry->f_clk;
+	dev->plan.f_clk = entry->f_clk;
+	dev->plan.f_vco = entry->f_clk << entry->clkout_div_sel;
+	dev->plan.n_int = entry->n_int;
+	dev->plan.clkout_div_sel = entry->clkout_div_sel;
+}
+
+/**
+ * @brief Retune to a calibrated hop table entry.
+ *
+ * The VCO core and band are forced to the stored values, so the calibration
+ * started by the N_INT LSB write only runs the VCO amplitude loop. The first
+ * hop enters the hopping mode: band and core overrides are enabled and the
+ * calibration clocks are kept running until adf4377_hop_exit().
+ * @param dev - The device structure.
+ * @param entry - Hop table entry.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_hop_unlocked(struct adf4377_dev *dev,
+				    const struct adf4377_hop_entry *entry)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	if (!dev->hop_mode) {
+		adf4377_batch_update(&batch, ADF4377_REG(0x3D),
+				     ADF4377_O_VCO_BAND_MSK | ADF4377_O_VCO_CORE_MSK,
+				     ADF4377_O_VCO_BAND(ADF4377_O_VCO_BAND_M_VCO) |
+				     ADF4377_O_VCO_CORE(ADF4377_O_VCO_CORE_M_VCO));
+		adf4377_cal_clocks(&batch, true);
+	}
+
+	adf4377_queue_hop(&batch, entry);
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_hop_commit(dev, entry);
+
+	return adf4377_wait_lock_unlocked(dev);
+}
+
+/**
+ * @brief adf4377_hop_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param entry - Hop table entry.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_hop(struct adf4377_dev *dev,
+		    const struct adf4377_hop_entry *entry)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_unlocked(dev, entry);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Build the wire frames of a sweep step.
+ *
+ * Only the hop registers differing from the previous step are sent, N_INT
+ * LSB is always written since it applies the step. In address ascending mode
+ * N_INT LSB goes in a separate frame, after the other registers.
+ * @param dev - The device structure.
+ * @param step - The sweep step, regs already filled in.
+ * @param prev - Hop register values of the previous step.
+ * @return None.
+ */
+static void adf4377_sweep_stage(struct adf4377_dev *dev,
+				struct adf4377_sweep_step *step,
+				const uint8_t *prev)
+{
+	uint8_t first, last = 0, len, i, n = 0;
+	uint8_t *buff = step->buff;
+
+	for (i = 1; i < ADF4377_SWEEP_REGS; i++)
+		if (step->regs[i] != prev[i])
+			last = i;
+
+	first = dev->addr_asc == ADF4377_ADDR_ASC_AUTO_DECR ? 0 : 1;
+
+	step->len[0] = 0;
+	step->len[1] = 0;
+
+	if (last >= first) {
+		len = last - first + 1;
+		adf4377_spi_burst_header(dev, ADF4377_SPI_WRITE_CMD,
+					 ADF4377_SWEEP_FIRST_REG + first, len, buff);
+		for (i = 0; i < len; i++)
+			buff[adf4377_spi_burst_pos(dev, len, i)] =
+				adf4377_spi_byte(dev, step->regs[first + i]);
+
+		step->len[n++] = ADF4377_SPI_INSTR_BYTES + len;
+		buff += ADF4377_SPI_INSTR_BYTES + len;
+	}
+
+	if (first) {
+		adf4377_spi_burst_header(dev, ADF4377_SPI_WRITE_CMD,
+					 ADF4377_SWEEP_FIRST_REG, 1, buff);
+		buff[ADF4377_SPI_INSTR_BYTES] = adf4377_spi_byte(dev, step->regs[0]);
+		step->len[n] = ADF4377_BUFF_SIZE_BYTES;
+	}
+}
+
+/**
+ * @brief Prestage the register payloads of a sweep over a hop table.
+ *
+ * The hop table comes from adf4377_hop_table_calibrate(), so every step only
+ * reprograms the dividers and the VCO selection, without a full calibration.
+ * The untouched bits of the hop registers are taken from the current
+ * configuration, which must not change until the sweep is stopped.
+ * @param dev - The device structure.
+ * @param sweep - The sweep state.
+ * @param param - The sweep parameters.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_sweep_prepare(struct adf4377_dev *dev,
+			      struct adf4377_sweep *sweep,
+			      const struct adf4377_sweep_param *param)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	struct adf4377_batch_entry *entry;
+	struct adf4377_sweep_step *step;
+	uint8_t base[ADF4377_SWEEP_REGS];
+	const uint8_t *prev;
+	uint8_t i, j, idx;
+	int32_t ret;
+
+	if (!dev || !sweep || !param || !param->table || !param->dwell_us ||
+	    !param->steps || !param->num_steps)
+		return -EINVAL;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_regmap_get_block(dev, ADF4377_SWEEP_FIRST_REG, base,
+				       ADF4377_SWEEP_REGS);
+	adf4377_unlock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	for (i = 0; i < param->num_steps; i++) {
+		step = &param->steps[i];
+		prev = i ? param->steps[i - 1].regs : base;
+		memcpy(step->regs, prev, ADF4377_SWEEP_REGS);
+
+		adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+		adf4377_queue_hop(&batch, &param->table[i]);
+		for (j = 0; j < batch.count; j++) {
+			entry = &batch.entries[j];
+			idx = entry->reg_addr - ADF4377_SWEEP_FIRST_REG;
+			step->regs[idx] = (step->regs[idx] & ~entry->mask) | entry->data;
+		}
+
+		step->dwell_us = param->dwell_us[i];
+	}
+
+	/* The first step is applied by adf4377_sweep_start(), its frames only
+	 * serve the restart after the last step */
+	for (i = 0; i < param->num_steps; i++) {
+		prev = param->steps[i ? i - 1 : param->num_steps - 1].regs;
+		adf4377_sweep_stage(dev, &param->steps[i], prev);
+	}
+
+	sweep->dev = dev;
+	sweep->table = param->table;
+	sweep->steps = param->steps;
+	sweep->num_steps = param->num_steps;
+	sweep->step = 0;
+	sweep->gate_lock = param->gate_lock;
+	sweep->repeat = param->repeat;
+	sweep->lock_misses = 0;
+	sweep->active = false;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Hop to the first step of a prepared sweep and wait for lock.
+ * @param sweep - The sweep state.
+ * @param dwell_us - Time in us until the first adf4377_sweep_tick().
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_sweep_start(struct adf4377_sweep *sweep, uint32_t *dwell_us)
+{
+	int32_t ret;
+
+	if (!sweep || !sweep->dev || sweep->active)
+		return -EINVAL;
+
+	ret = adf4377_hop(sweep->dev, &sweep->table[0]);
+	if (ret != SUCCESS)
+		return ret;
+
+	sweep->step = 0;
+	sweep->lock_misses = 0;
+	sweep->active = true;
+	*dwell_us = sweep->steps[0].dwell_us;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Apply the next sweep step.
+ *
+ * To be called from a hardware timer interrupt, reprogrammed with the
+ * returned dwell time. Only the prestaged frames go out on the bus, plus one
+ * lock status read when gating on lock and no LKDET GPIO is available. The
+ * sweep stops by itself after the last step unless restarting, that last
+ * call also checking the lock of the final step. The lock and reference loss
+ * events are armed again whenever a step is found locked. With a device or
+ * bus lock, the timer callback must run in task context.
+ * @param sweep - The sweep state.
+ * @param dwell_us - Time in us until the next call, 0 once the sweep ended.
+ * @return SUCCESS when a step was applied or the sweep ended, -EAGAIN when
+ * the previous step is not locked yet, the step being retried after
+ * ADF4377_LOCK_POLL_US, -EINVAL when no sweep is running, or another
+ * negative error code.
+ */
+int32_t adf4377_sweep_tick(struct adf4377_sweep *sweep, uint32_t *dwell_us)
+{
+	struct adf4377_dev *dev = sweep->dev;
+	struct adf4377_sweep_step *step;
+	uint8_t buff[ADF4377_SWEEP_FRAME_SIZE];
+	uint8_t next, i, off = 0;
+	bool locked, last;
+	int32_t ret;
+
+	if (!sweep->active)
+		return -EINVAL;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	next = sweep->step + 1;
+	last = next == sweep->num_steps && !sweep->repeat;
+	if (next == sweep->num_steps)
+		next = 0;
+
+	if (sweep->gate_lock || last) {
+		ret = adf4377_get_lock_unlocked(dev, &locked);
+		if (ret != SUCCESS)
+			goto exit;
+
+		if (locked) {
+			/* Report the losses of the step in place until the next one */
+			dev->events_armed = true;
+		} else if (sweep->gate_lock) {
+			sweep->lock_misses++;
+			*dwell_us = ADF4377_LOCK_POLL_US;
+			ret = -EAGAIN;
+			goto exit;
+		}
+	}
+
+	if (last) {
+		sweep->active = false;
+		*dwell_us = 0;
+		goto exit;
+	}
+
+	step = &sweep->steps[next];
+
+	/* The frames are read back into the buffer in full duplex mode */
+	memcpy(buff, step->buff, sizeof(buff));
+
+	dev->events_armed = false;
+
+	for (i = 0; i < ARRAY_SIZE(step->len) && step->len[i]; i++) {
+		ret = adf4377_spi_xfer(dev, &buff[off], step->len[i]);
+		if (ret != SUCCESS) {
+			sweep->active = false;
+			adf4377_regmap_invalidate(dev);
+			goto exit;
+		}
+		off += step->len[i];
+	}
+
+	adf4377_cal_start(dev, ADF4377_SWEEP_FIRST_REG, ADF4377_SWEEP_REGS);
+	for (i = 0; i < ADF4377_SWEEP_REGS; i++)
+		adf4377_reg_cache(dev, ADF4377_SWEEP_FIRST_REG + i, step->regs[i]);
+
+	adf4377_hop_commit(dev, &sweep->table[next]);
+
+	sweep->step = next;
+	*dwell_us = step->dwell_us;
+
+exit:
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Stop a sweep, the device stays at the current step.
+ * @param sweep - The sweep state.
+ * @return None.
+ */
+void adf4377_sweep_stop(struct adf4377_sweep *sweep)
+{
+	sweep->active = false;
+}
+
+/**
+ * @brief Read the whole register map with a single burst transfer.
+ * @param dev - The device structure.
+ * @param regs - Buffer of ADF4377_REGMAP_SIZE bytes, indexed by address.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_regmap_dump_unlocked(struct adf4377_dev *dev,
+					    uint8_t *regs)
+{
+	adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+
+	return adf4377_spi_read_burst(dev, ADF4377_REG(0x00), regs,
+				      ADF4377_REGMAP_SIZE);
+}
+
+/**
+ * @brief adf4377_regmap_dump_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param regs - Buffer of ADF4377_REGMAP_SIZE bytes, indexed by address.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_regmap_dump(struct adf4377_dev *dev, uint8_t *regs)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_regmap_dump_unlocked(dev, regs);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Rebuild the frequency plan programmed by a register map snapshot.
+ *
+ * The reference clock is assumed unchanged, the doubler, dividers, loop
+ * settings and calibration timeouts come from the snapshot. The plan is
+ * marked tuned when the bleed current is enabled or the timeouts differ from
+ * the computed ones.
+ * @param dev - The device structure.
+ * @param regs - Buffer of ADF4377_REGMAP_SIZE bytes, indexed by address.
+ * @param plan - The frequency plan.
+ * @param pfd_plan - The same plan with the computed timeouts, for
+ * 		     dev->pfd_plan.
+ * @return Returns SUCCESS in case of success or -EINVAL if the snapshot does
+ * not hold a valid frequency plan.
+ */
+static int32_t adf4377_plan_from_regs(struct adf4377_dev *dev,
+				      const uint8_t *regs,
+				      struct adf4377_freq_plan *plan,
+				      struct adf4377_freq_plan *pfd_plan)
+{
+	const struct adf4377_chip_info *info = ADF4377_CHIP_INFO(dev);
+	uint16_t n_int, synth_lock_timeout, vco_alc_timeout;
+
+	memset(plan, 0, sizeof(*plan));
+	plan->clkin_freq = dev->clkin_freq;
+	plan->ref_doubler_en = field_get(ADF4377_EN_RDBLR_MSK,
+					 regs[ADF4377_REG(0x11)]);
+	plan->ref_div_factor = field_get(ADF4377_R_DIV_MSK, regs[ADF4377_REG(0x12)]);
+	if (!plan->ref_div_factor)
+		return -EINVAL;
+
+	plan->f_pfd = (uint64_t)dev->clkin_freq * (1 + plan->ref_doubler_en) /
+		      plan->ref_div_factor;
+	if(ADF4377_CHECK_RANGE(plan->f_pfd, FREQ_PFD))
+		return -EINVAL;
+
+	n_int = (field_get(ADF4377_N_INT_MSB_MSK, regs[ADF4377_REG(0x11)]) << 8) |
+		regs[ADF4377_REG(0x10)];
+	plan->f_clk = (uint64_t)n_int * plan->f_pfd;
+	if (plan->f_clk < info->min_freq || plan->f_clk > info->max_freq)
+		return -EINVAL;
+
+	adf4377_plan_dividers(plan);
+	if (plan->clkout_div_sel != field_get(ADF4377_CLKOUT_DIV_MSK,
+					      regs[ADF4377_REG(0x12)]))
+		return -EINVAL;
+
+	plan->tuned = false;
+	*pfd_plan = *plan;
+
+	plan->cp_i = field_get(ADF4377_CP_I_MSK, regs[ADF4377_REG(0x15)]);
+	plan->bleed_en = field_get(ADF4377_EN_BLEED_MSK, regs[ADF4377_REG(0x15)]);
+	plan->bleed_pol = field_get(ADF4377_BLEED_POL_MSK, regs[ADF4377_REG(0x15)]);
+	plan->bleed_i = (regs[ADF4377_REG(0x16)] << 2) |
+			field_get(ADF4377_BLEED_I_LSB_MSK, regs[ADF4377_REG(0x15)]);
+
+	synth_lock_timeout = (field_get(ADF4377_SYNTH_LOCK_TO_MSB_MSK,
+					regs[ADF4377_REG(0x28)]) << 8) | regs[ADF4377_REG(0x27)];
+	vco_alc_timeout = (field_get(ADF4377_VCO_ALC_TO_MSB_MSK,
+				     regs[ADF4377_REG(0x2A)]) << 8) | regs[ADF4377_REG(0x29)];
+	plan->tuned = plan->bleed_en ||
+		      synth_lock_timeout != plan->synth_lock_timeout ||
+		      vco_alc_timeout != plan->vco_alc_timeout;
+	plan->synth_lock_timeout = synth_lock_timeout;
+	plan->vco_alc_timeout = vco_alc_timeout;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Restore the configuration registers from a register map snapshot.
+ *
+ * Registers ADF4377_RESTORE_FIRST_REG to ADF4377_RESTORE_LAST_REG are written
+ * in as few bursts as possible, skipping the volatile ones. The VCO
+ * calibration clocks are kept enabled until the PLL locks on the restored
+ * dividers, then set to their snapshot value. The interface, identification
+ * and status registers are left untouched. The frequency plan, output
+ * frequency and loop settings of the descriptor are rebuilt from the
+ * snapshot.
+ * @param dev - The device structure.
+ * @param regs - Buffer of ADF4377_REGMAP_SIZE bytes, indexed by address.
+ * @return Returns SUCCESS in case of success, -EINVAL if the snapshot does not
+ * hold a valid frequency plan or another negative error code.
+ */
+static int32_t adf4377_regmap_restore_unlocked(struct adf4377_dev *dev,
+					       const uint8_t *regs)
+{
+	struct adf4377_freq_plan plan, pfd_plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_REGMAP_SIZE];
+	uint8_t reg;
+	int32_t ret;
+
+	ret = adf4377_plan_from_regs(dev, regs, &plan, &pfd_plan);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	for (reg = ADF4377_RESTORE_FIRST_REG; reg <= ADF4377_RESTORE_LAST_REG; reg++)
+		if (!adf4377_reg_volatile(reg))
+			adf4377_batch_write(&batch, reg, regs[reg]);
+
+	adf4377_cal_clocks(&batch, true);
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->hop_mode = !!(regs[ADF4377_REG(0x3D)] & ADF4377_O_VCO_CORE_MSK);
+	dev->delay = field_get(ADF4377_R_DEL_MSK, regs[ADF4377_REG(0x18)]) -
+		     field_get(ADF4377_N_DEL_MSK, regs[ADF4377_REG(0x17)]);
+	dev->double_buffer = !!(regs[ADF4377_REG(0x25)] & ADF4377_CLKODIV_DB_MSK);
+	dev->plan = plan;
+	dev->f_clk = plan.f_clk;
+	dev->ref_doubler_en = plan.ref_doubler_en;
+	dev->pfd_plan = pfd_plan;
+	dev->pfd_recip = adf4377_pfd_recip(pfd_plan.f_pfd);
+	dev->cp_i = plan.cp_i;
+	dev->clkout_op = field_get(ADF4377_CLKOUT1_OP_MSK, regs[ADF4377_REG(0x19)]);
+	dev->cal_temp_valid = false;
+
+	ret = adf4377_wait_lock_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_batch_write(&batch, ADF4377_REG(0x1C), regs[ADF4377_REG(0x1C)]);
+	adf4377_batch_write(&batch, ADF4377_REG(0x20), regs[ADF4377_REG(0x20)]);
+
+	return adf4377_batch_flush_unlocked(dev, &batch);
+}
+
+/**
+ * @brief adf4377_regmap_restore_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param regs - Buffer of ADF4377_REGMAP_SIZE bytes, indexed by address.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_regmap_restore(struct adf4377_dev *dev, const uint8_t *regs)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_regmap_restore_unlocked(dev, regs);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+#ifdef ADF4377_TRACE
+/**
+ * @brief Re-issue the register accesses of an SPI trace.
+ *
+ * Each transfer of the trace is issued again as a single access or a burst,
+ * in the interface configuration of the device. Reads are compared with the
+ * recorded values, skipping the volatile registers and the failed transfers.
+ * When timed, the delays between the recorded transfers are reproduced, so
+ * the polling and calibration waits of the capture are replayed as well.
+ * The shadow cache is dropped on return since the trace may have reset or
+ * reprogrammed the device, the rest of the device state is left unchanged.
+ * @param dev - The device structure.
+ * @param recs - The records, oldest first, from adf4377_trace_read().
+ * @param num - Number of records.
+ * @param timed - true to reproduce the recorded delays.
+ * @param mismatches - Number of read values different from the trace.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_trace_replay_unlocked(struct adf4377_dev *dev,
+					     const struct adf4377_trace_rec *recs,
+					     uint16_t num, bool timed,
+					     uint16_t *mismatches)
+{
+	uint8_t data[ADF4377_REGMAP_SIZE];
+	uint32_t next_us = 0;
+	uint16_t i, len, k;
+	int32_t ret = SUCCESS;
+
+	*mismatches = 0;
+
+	for (i = 0; i < num; i += len) {
+		for (len = 1; i + len < num && (recs[i + len].flags & ADF4377_TRACE_CONT);
+		     len++)
+			;
+
+		if (recs[i].reg_addr + len > ADF4377_REGMAP_SIZE) {
+			ret = -EINVAL;
+			break;
+		}
+
+		if (timed && i && recs[i].time_us > next_us)
+			adf4377_delay_us(dev, recs[i].time_us - next_us);
+		next_us = recs[i].time_us +
+			  DIV_ROUND_UP((ADF4377_SPI_INSTR_BYTES + len) * 8 * 1000000,
+				       dev->spi_desc->max_speed_hz);
+
+		if (!(recs[i].flags & ADF4377_TRACE_READ)) {
+			for (k = 0; k < len; k++)
+				data[k] = recs[i + k].data;
+
+			if (len == 1)
+				ret = adf4377_spi_write(dev, recs[i].reg_addr, data[0]);
+			else
+				ret = adf4377_spi_write_burst(dev, recs[i].reg_addr, data,
+							      len);
+			if (ret != SUCCESS)
+				break;
+
+			continue;
+		}
+
+		if (len == 1)
+			ret = adf4377_spi_read(dev, recs[i].reg_addr, data);
+		else
+			ret = adf4377_spi_read_burst(dev, recs[i].reg_addr, data, len);
+		if (ret != SUCCESS)
+			break;
+
+		for (k = 0; k < len; k++)
+			if (recs[i + k].ret == SUCCESS &&
+			    !adf4377_reg_volatile(recs[i + k].reg_addr) &&
+			    data[k] != recs[i + k].data)
+				(*mismatches)++;
+	}
+
+	adf4377_regmap_invalidate(dev);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_trace_replay_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param recs - The records, oldest first, from adf4377_trace_read().
+ * @param num - Number of records.
+ * @param timed - true to reproduce the recorded delays.
+ * @param mismatches - Number of read values different from the trace.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_trace_replay(struct adf4377_dev *dev,
+			     const struct adf4377_trace_rec *recs, uint16_t num,
+			     bool timed, uint16_t *mismatches)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_trace_replay_unlocked(dev, recs, num, timed, mismatches);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+#endif
+
+/**
+ * @brief Get the interface configuration of REG0000.
+ * @param dev - The device structure.
+ * @return The REG0000 value.
+ */
+static uint8_t adf4377_if_config(struct adf4377_dev *dev)
+{
+	return ADF4377_LSB_FIRST_R(ADF4377_SPI_LSB_FIRST(dev)) |
+	       ADF4377_LSB_FIRST(ADF4377_SPI_LSB_FIRST(dev)) |
+	       ADF4377_SDO_ACTIVE_R(dev->spi3wire) |
+	       ADF4377_SDO_ACTIVE(dev->spi3wire) |
+	       ADF4377_ADDRESS_ASC_R(dev->addr_asc) |
+	       ADF4377_ADDRESS_ASC(dev->addr_asc);
+}
+
+
+/**
+ * @brief Get the bits of a register compared by adf4377_verify().
+ * @param reg_addr - The register address.
+ * @return The compare mask.
+ */
+static uint8_t adf4377_verify_mask(uint8_t reg_addr)
+{
+	/* The soft reset bits clear themselves */
+	if (reg_addr == ADF4377_REG(0x00))
+		return (uint8_t)~(ADF4377_SOFT_RESET_MSK | ADF4377_SOFT_RESET_R_MSK);
+
+	return 0xFF;
+}
+
+/**
+ * @brief Check the programmed configuration against the shadow cache.
+ *
+ * Every cached register, plus the interface configuration of REG0000, is
+ * read back with one burst per range of cached registers, small gaps being
+ * read through rather than starting a new burst. Volatile registers are
+ * never cached so they are not compared. The cache then holds the values
+ * read from the device.
+ * @param dev - The device structure.
+ * @param diffs - Mismatched registers, may be NULL if max_diffs is 0.
+ * @param max_diffs - Number of entries available in diffs.
+ * @param num_diffs - Number of mismatched registers, possibly above
+ * 		      max_diffs.
+ * @return SUCCESS if the configuration matches, -EIO on a mismatch, or
+ * another negative error code.
+ */
+static int32_t adf4377_verify_unlocked(struct adf4377_dev *dev,
+				       struct adf4377_verify_diff *diffs,
+				       uint8_t max_diffs, uint8_t *num_diffs)
+{
+	uint8_t expected[ADF4377_REGMAP_SIZE], actual[ADF4377_REGMAP_SIZE];
+	uint8_t valid[DIV_ROUND_UP(ADF4377_REGMAP_SIZE, 8)];
+	uint8_t first, last, i, j, n = 0;
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+
+	memcpy(expected, dev->regmap, sizeof(expected));
+	memcpy(valid, dev->regmap_valid, sizeof(valid));
+	expected[ADF4377_REG(0x00)] = adf4377_if_config(dev);
+	valid[0] |= BIT(ADF4377_REG(0x00));
+
+	i = 0;
+	while (i < ADF4377_REGMAP_SIZE) {
+		if (!(valid[i / 8] & BIT(i % 8))) {
+			i++;
+			continue;
+		}
+
+		first = last = i;
+		for (i++; i < ADF4377_REGMAP_SIZE &&
+		     i - last - 1 <= ADF4377_BATCH_MAX_GAP; i++)
+			if (valid[i / 8] & BIT(i % 8))
+				last = i;
+
+		ret = adf4377_spi_read_burst(dev, first, &actual[first],
+					     last - first + 1);
+		if (ret != SUCCESS)
+			return ret;
+
+		for (j = first; j <= last; j++) {
+			if (!(valid[j / 8] & BIT(j % 8)) ||
+			    !((expected[j] ^ actual[j]) & adf4377_verify_mask(j)))
+				continue;
+
+			if (n < max_diffs) {
+				diffs[n].reg_addr = j;
+				diffs[n].expected = expected[j];
+				diffs[n].actual = actual[j];
+			}
+			n++;
+		}
+	}
+
+	*num_diffs = n;
+
+	return n ? -EIO : SUCCESS;
+}
+
+/**
+ * @brief adf4377_verify_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param diffs - Mismatched registers, may be NULL if max_diffs is 0.
+ * @param max_diffs - Number of entries available in diffs.
+ * @param num_diffs - Number of mismatched registers, possibly above
+ * 		      max_diffs.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_verify(struct adf4377_dev *dev,
+		       struct adf4377_verify_diff *diffs, uint8_t max_diffs,
+		       uint8_t *num_diffs)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_verify_unlocked(dev, diffs, max_diffs, num_diffs);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Verify the configuration if enabled in the init parameters.
+ * @param dev - The device structure.
+ * @return SUCCESS if verification is disabled or passes, negative error code
+ * otherwise, the mismatches being kept in the device structure.
+ */
+static int32_t adf4377_verify_auto(struct adf4377_dev *dev)
+{
+	if (!dev->verify)
+		return SUCCESS;
+
+	return adf4377_verify_unlocked(dev, dev->verify_diffs,
+				       ARRAY_SIZE(dev->verify_diffs), &dev->num_verify_diffs);
+}
+
+/**
+ * @brief Queue the delay line settings of a reference to output delay.
+ * @param batch - The batch to queue the register updates in.
+ * @param delay - Delay in steps, positive on the reference path, negative on
+ * the feedback path.
+ * @return None.
+ */
+static void adf4377_queue_delay(struct adf4377_batch *batch, int16_t delay)
+{
+	adf4377_batch_update(batch, ADF4377_REG(0x18), ADF4377_R_DEL_MSK,
+			     ADF4377_R_DEL(delay > 0 ? delay : 0));
+	adf4377_batch_update(batch, ADF4377_REG(0x17), ADF4377_N_DEL_MSK,
+			     ADF4377_N_DEL(delay < 0 ? -delay : 0));
+}
+
+/**
+ * @brief Stage a new reference to output delay.
+ *
+ * The delay lines are double buffered, the new setting only reaches the
+ * output with the next adf4377_sync(), frequency change or hop.
+ * @param dev - The device structure.
+ * @param delay - Delay in steps, from ADF4377_DELAY_MIN to ADF4377_DELAY_MAX.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_stage_delay_unlocked(struct adf4377_dev *dev,
+					    int16_t delay)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[2];
+	int32_t ret;
+
+	if (delay < ADF4377_DELAY_MIN || delay > ADF4377_DELAY_MAX)
+		return -EINVAL;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_queue_delay(&batch, delay);
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->delay = delay;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_stage_delay_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param delay - Delay in steps, from ADF4377_DELAY_MIN to ADF4377_DELAY_MAX.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_stage_delay(struct adf4377_dev *dev, int16_t delay)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_stage_delay_unlocked(dev, delay);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Load the staged delay line settings, without VCO calibration.
+ *
+ * The double buffers are loaded by the N_INT LSB write, which is issued with
+ * the automatic calibration disabled so the output keeps running.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sync_start(struct adf4377_dev *dev)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[2];
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_batch_update(&batch, ADF4377_REG(0x11), ADF4377_EN_AUTOCAL_MSK,
+			     ADF4377_EN_AUTOCAL(ADF4377_VCO_CALIB_DIS));
+	adf4377_batch_write(&batch, ADF4377_REG(0x10),
+			    ADF4377_N_INT_LSB(dev->plan.n_int));
+
+	return adf4377_batch_flush_unlocked(dev, &batch);
+}
+
+/**
+ * @brief Enable the automatic calibration again after adf4377_sync_start().
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sync_end(struct adf4377_dev *dev)
+{
+	return adf4377_update_unlocked(dev, ADF4377_REG(0x11), ADF4377_EN_AUTOCAL_MSK,
+				       ADF4377_EN_AUTOCAL(ADF4377_VCO_CALIB_EN));
+}
+
+/**
+ * @brief Apply the staged delay line settings and wait for lock.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sync_unlocked(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_sync_start(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_sync_end(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_wait_lock_unlocked(dev);
+}
+
+/**
+ * @brief adf4377_sync_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_sync(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_sync_unlocked(dev);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Set the reference to output delay of an initialized device.
+ * @param dev - The device structure.
+ * @param delay - Delay in steps, from ADF4377_DELAY_MIN to ADF4377_DELAY_MAX.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_delay_unlocked(struct adf4377_dev *dev,
+					  int16_t delay)
+{
+	int32_t ret;
+
+	ret = adf4377_stage_delay_unlocked(dev, delay);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_sync_unlocked(dev);
+}
+
+/**
+ * @brief adf4377_set_delay_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param delay - Delay in steps, from ADF4377_DELAY_MIN to ADF4377_DELAY_MAX.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_delay(struct adf4377_dev *dev, int16_t delay)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_delay_unlocked(dev, delay);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Retune the output frequency of an initialized device.
+ *
+ * Only the feedback and output dividers are reprogrammed, followed by a VCO
+ * calibration and the wait for lock. Registers keeping their value are not
+ * written.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_frequency_unlocked(struct adf4377_dev *dev,
+					      uint64_t f_clk)
+{
+	struct adf4377_freq_plan plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	int32_t ret;
+
+	ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en, f_clk,
+			       &plan);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	ret = adf4377_calibrate(dev, &plan, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_verify_auto(dev);
+}
+
+/**
+ * @brief adf4377_set_frequency_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_frequency(struct adf4377_dev *dev, uint64_t f_clk)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_frequency_unlocked(dev, f_clk);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Check the candidates of a lock time tuning.
+ * @param param - Tuning parameters.
+ * @return SUCCESS if valid, -EINVAL otherwise.
+ */
+static int32_t adf4377_tune_check(const struct adf4377_tune_param *param)
+{
+	uint8_t i;
+
+	if (!param->trials || param->bleed_pol > ADF4377_CURRENT_SOURCE ||
+	    (param->cp_i && !param->num_cp_i) ||
+	    (param->bleed_i && !param->num_bleed_i) ||
+	    (param->timeout_pct && !param->num_timeout_pct))
+		return -EINVAL;
+
+	for (i = 0; param->cp_i && i < param->num_cp_i; i++)
+		if (param->cp_i[i] > ADF4377_CP_10MA1)
+			return -EINVAL;
+
+	for (i = 0; param->bleed_i && i < param->num_bleed_i; i++)
+		if (param->bleed_i[i] > ADF4377_BLEED_I_MAX)
+			return -EINVAL;
+
+	for (i = 0; param->timeout_pct && i < param->num_timeout_pct; i++)
+		if (!param->timeout_pct[i] ||
+		    param->timeout_pct[i] > ADF4377_TUNE_PCT_MAX)
+			return -EINVAL;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Tune the loop settings and calibration timeouts of a frequency.
+ *
+ * Every combination of the candidate charge pump currents, bleed currents
+ * and calibration timeouts is calibrated param->trials times, measuring the
+ * lock time as adf4377_wait_lock() does. A candidate failing to lock within
+ * the budget of the untuned plan in any trial is dropped, the others are
+ * ranked by their longest lock time, ties going to the first candidate. The
+ * device is left locked with the winning settings. The returned plan can be
+ * placed in init_param->freq_plans to apply the settings at every later
+ * retune to the frequency, including the hop table calibration.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @param param - Tuning parameters.
+ * @param plan - The tuned frequency plan.
+ * @return SUCCESS in case of success, -ETIMEDOUT if no candidate locked or
+ * negative error code otherwise.
+ */
+static int32_t adf4377_tune_plan_unlocked(struct adf4377_dev *dev,
+					  uint64_t f_clk,
+					  const struct adf4377_tune_param *param,
+					  struct adf4377_freq_plan *plan)
+{
+	struct adf4377_freq_plan base, cand;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	uint8_t num_cp_i, num_bleed_i, num_pct, c, b, t, k;
+	uint32_t pct, worst, best = 0;
+	bool found = false;
+	int32_t ret;
+
+	ret = adf4377_tune_check(param);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en, f_clk,
+			       &base);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	num_cp_i = param->cp_i ? param->num_cp_i : 1;
+	num_bleed_i = param->bleed_i ? param->num_bleed_i : 1;
+	num_pct = param->timeout_pct ? param->num_timeout_pct : 1;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	for (t = 0; t < num_pct; t++) {
+		pct = param->timeout_pct ? param->timeout_pct[t] : ADF4377_TUNE_PCT_MAX;
+
+		for (c = 0; c < num_cp_i; c++) {
+			for (b = 0; b < num_bleed_i; b++) {
+				cand = base;
+				cand.tuned = true;
+
+				if (param->cp_i)
+					cand.cp_i = param->cp_i[c];
+
+				if (param->bleed_i && param->bleed_i[b]) {
+					cand.bleed_en = ADF4377_BLEED_CURR_EN;
+					cand.bleed_pol = param->bleed_pol;
+					cand.bleed_i = param->bleed_i[b];
+				}
+
+				cand.synth_lock_timeout = DIV_ROUND_UP(base.synth_lock_timeout *
+							      pct, 100);
+				cand.vco_alc_timeout = DIV_ROUND_UP(base.vco_alc_timeout * pct,
+								    100);
+
+				worst = 0;
+				for (k = 0; k < param->trials; k++) {
+					ret = adf4377_calibrate(dev, &cand, &batch);
+					if (ret != SUCCESS)
+						break;
+
+					worst = max(worst, dev->lock_time_us);
+				}
+
+				if (ret == -ETIMEDOUT)
+					continue;
+				if (ret != SUCCESS)
+					return ret;
+
+				if (!found || worst < best) {
+					*plan = cand;
+					best = worst;
+					found = true;
+				}
+			}
+		}
+	}
+
+	ret = adf4377_calibrate(dev, found ? plan : &base, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	if (!found)
+		return -ETIMEDOUT;
+
+	return adf4377_verify_auto(dev);
+}
+
+/**
+ * @brief adf4377_tune_plan_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @param param - Tuning parameters.
+ * @param plan - The tuned frequency plan.
+ * @return SUCCESS in case of success, -ETIMEDOUT if no candidate locked or
+ * negative error code otherwise.
+ */
+int32_t adf4377_tune_plan(struct adf4377_dev *dev, uint64_t f_clk,
+			  const struct adf4377_tune_param *param,
+			  struct adf4377_freq_plan *plan)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_tune_plan_unlocked(dev, f_clk, param, plan);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+#ifdef ADF4377_ASYNC
+/**
+ * @brief Change the output frequency without blocking.
+ *
+ * Same sequence as adf4377_set_frequency(), run as one job: the calibration
+ * clocks and dividers are written, the lock status is polled over the bus
+ * and the calibration clocks are disabled again once locked. The new plan is
+ * committed when done() reports SUCCESS. Leaving the hopping mode, when
+ * active, is done before the job starts and blocks.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @param done - Completion callback, called from the transport completion
+ * 		 interrupt.
+ * @param ctx - Completion callback context.
+ * @return Returns SUCCESS when the job is started or negative error code.
+ */
+static int32_t adf4377_set_frequency_async_unlocked(struct adf4377_dev *dev,
+						    uint64_t f_clk,
+						    void (*done)(void *ctx, int32_t status),
+						    void *ctx)
+{
+	struct adf4377_async_job *job = &dev->job;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+	uint32_t poll_us;
+	int32_t ret;
+
+	if (job->busy)
+		return -EBUSY;
+
+	ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en, f_clk,
+			       &job->plan);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_async_begin(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	/* N_INT LSB is committed last and starts the calibration */
+	adf4377_cal_clocks(&batch, true);
+	if (job->plan.f_pfd != dev->plan.f_pfd)
+		adf4377_set_pfd(&batch, &job->plan);
+	adf4377_queue_loop(dev, &batch, &job->plan);
+	adf4377_queue_freq(&batch, &job->plan);
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		goto error;
+
+	poll_us = DIV_ROUND_UP(ADF4377_BUFF_SIZE_BYTES * 8 * 1000000,
+			       dev->spi_desc->max_speed_hz);
+	if (dev->async_ops->schedule)
+		poll_us += ADF4377_LOCK_POLL_US;
+	job->lock_polls = DIV_ROUND_UP(job->plan.lock_timeout_us, poll_us) + 1;
+	job->lock_frame = job->num_frames;
+	job->lock_wait = true;
+
+	adf4377_cal_clocks(&batch, false);
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		goto error;
+
+	job->plan_valid = true;
+
+	return adf4377_async_start(dev, done, ctx);
+
+error:
+	adf4377_async_abort(dev);
+
+	return ret;
+}
+
+/**
+ * @brief adf4377_set_frequency_async_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @param done - Completion callback.
+ * @param ctx - Completion callback context.
+ * @return SUCCESS when the job is started, negative error code otherwise.
+ */
+int32_t adf4377_set_frequency_async(struct adf4377_dev *dev, uint64_t f_clk,
+				    void (*done)(void *ctx, int32_t status),
+				    void *ctx)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_frequency_async_unlocked(dev, f_clk, done, ctx);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+#endif
+
+/**
+ * @brief Change the reference of an initialized device.
+ *
+ * The PFD dependent dividers and calibration timeouts are reprogrammed when
+ * the PFD frequency changes, then the current output frequency is retuned.
+ * @param dev - The device structure.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param ref_doubler_en - Reference doubler enable.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_reference_unlocked(struct adf4377_dev *dev,
+					      uint32_t clkin_freq,
+					      uint8_t ref_doubler_en)
+{
+	struct adf4377_freq_plan plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_SETUP_BATCH_SIZE];
+	int32_t ret;
+
+	ret = adf4377_get_plan(dev, clkin_freq, ref_doubler_en, dev->f_clk,
+			       &plan);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_hop_exit_unlocked(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	ret = adf4377_calibrate(dev, &plan, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->clkin_freq = clkin_freq;
+	dev->ref_doubler_en = plan.ref_doubler_en;
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_verify_auto(dev);
+}
+
+/**
+ * @brief adf4377_set_reference_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param clkin_freq - Input reference clock frequency.
+ * @param ref_doubler_en - Reference doubler enable.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_reference(struct adf4377_dev *dev, uint32_t clkin_freq,
+			      uint8_t ref_doubler_en)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_reference_unlocked(dev, clkin_freq, ref_doubler_en);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Set the charge pump current.
+ * @param dev - The device structure.
+ * @param cp_i - Charge pump current code, ADF4377_CP_0MA7 to ADF4377_CP_10MA1.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_cp_current_unlocked(struct adf4377_dev *dev,
+					       uint8_t cp_i)
+{
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	if (cp_i > ADF4377_CP_10MA1)
+		return -EINVAL;
+
+	ret = adf4377_update_unlocked(dev, ADF4377_REG(0x15), ADF4377_CP_I_MSK,
+				      ADF4377_CP_I(cp_i));
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->cp_i = cp_i;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_set_cp_current_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param cp_i - Charge pump current code, ADF4377_CP_0MA7 to ADF4377_CP_10MA1.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_cp_current(struct adf4377_dev *dev, uint8_t cp_i)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_cp_current_unlocked(dev, cp_i);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Set the amplitude of both clock outputs.
+ * @param dev - The device structure.
+ * @param clkout_op - Output amplitude, ADF4377_CLKOUT_320MV to
+ * 		      ADF4377_CLKOUT_640MV.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_output_power_unlocked(struct adf4377_dev *dev,
+						 uint8_t clkout_op)
+{
+	int32_t ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	if (clkout_op > ADF4377_CLKOUT_640MV)
+		return -EINVAL;
+
+	ret = adf4377_update_unlocked(dev, ADF4377_REG(0x19),
+				      ADF4377_CLKOUT2_OP_MSK | ADF4377_CLKOUT1_OP_MSK,
+				      ADF4377_CLKOUT1_OP(clkout_op) | ADF4377_CLKOUT2_OP(clkout_op));
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->clkout_op = clkout_op;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_set_output_power_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param clkout_op - Output amplitude, ADF4377_CLKOUT_320MV to
+ * 		      ADF4377_CLKOUT_640MV.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_output_power(struct adf4377_dev *dev, uint8_t clkout_op)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_output_power_unlocked(dev, clkout_op);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Enable or disable the double buffered retune mode.
+ *
+ * In this mode the updates of a retune are staged and committed together by
+ * the N_INT LSB write which also starts the calibration, so the synthesizer
+ * never runs on a mix of old and new divider settings.
+ * @param dev - The device structure.
+ * @param enable - true to enable the mode, false to disable it.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_set_double_buffer_unlocked(struct adf4377_dev *dev,
+						  bool enable)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[2];
+	int32_t ret;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_queue_double_buffer(&batch, enable);
+
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	dev->double_buffer = enable;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief adf4377_set_double_buffer_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param enable - true to enable the mode, false to disable it.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_set_double_buffer(struct adf4377_dev *dev, bool enable)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_double_buffer_unlocked(dev, enable);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Run a single ADC conversion and read the die temperature.
+ *
+ * The ADC is switched from VCO calibration use to single conversions for the
+ * duration of the measurement, then switched back.
+ * @param dev - The device structure.
+ * @param temp - The die temperature in degrees Celsius.
+ * @param status - The REG0049 status read at the end of the conversion.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_read_temp(struct adf4377_dev *dev, int16_t *temp,
+				 uint8_t *status)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[2];
+	uint32_t elapsed = 0;
+	uint8_t data[2];
+	int32_t ret, ret_restore;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_batch_update(&batch, ADF4377_REG(0x20), ADF4377_EN_ADC_CLK_MSK,
+			     ADF4377_EN_ADC_CLK(ADF4377_EN_ADC_CLK_EN));
+	adf4377_batch_update(&batch, ADF4377_REG(0x2E), ADF4377_ADC_A_CONV_MSK,
+			     ADF4377_ADC_A_CONV(ADF4377_ADC_A_CONV_ADC_ST_CNV));
+	ret = adf4377_batch_flush_unlocked(dev, &batch);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_spi_write(dev, ADF4377_REG(0x45),
+				ADF4377_ADC_ST_CNV(ADF4377_ADC_ST_ADC_EN));
+	if (ret != SUCCESS)
+		goto restore;
+
+	while (true) {
+		ret = adf4377_spi_read(dev, ADF4377_REG(0x49), status);
+		if (ret != SUCCESS)
+			goto restore;
+
+		if (!(*status & ADF4377_ADC_BUSY_MSK))
+			break;
+
+		if (elapsed >= ADF4377_ADC_TIMEOUT_US) {
+			ret = -ETIMEDOUT;
+			goto restore;
+		}
+
+		adf4377_delay_us(dev, ADF4377_LOCK_POLL_US);
+		elapsed += ADF4377_LOCK_POLL_US;
+	}
+
+	ret = adf4377_spi_read_burst(dev, ADF4377_REG(0x4C), data, 2);
+	if (ret != SUCCESS)
+		goto restore;
+
+	*temp = ((data[1] & ADF4377_CHIP_TEMP_MSB_MSK) << 8) | data[0];
+	/* 9-bit two's complement */
+	if (*temp & BIT(8))
+		*temp -= BIT(9);
+
+restore:
+	adf4377_batch_update(&batch, ADF4377_REG(0x2E), ADF4377_ADC_A_CONV_MSK,
+			     ADF4377_ADC_A_CONV(ADF4377_ADC_A_CONV_VCO_CALIB));
+	if (!dev->hop_mode)
+		adf4377_batch_update(&batch, ADF4377_REG(0x20), ADF4377_EN_ADC_CLK_MSK,
+				     ADF4377_EN_ADC_CLK(ADF4377_EN_ADC_CLK_DIS));
+	ret_restore = adf4377_batch_flush_unlocked(dev, &batch);
+
+	return ret != SUCCESS ? ret : ret_restore;
+}
+
+/**
+ * @brief Run a single ADC conversion and read the die temperature.
+ * @param dev - The device structure.
+ * @param temp - The die temperature in degrees Celsius.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_get_temp_unlocked(struct adf4377_dev *dev, int16_t *temp)
+{
+	uint8_t status;
+
+	return adf4377_read_temp(dev, temp, &status);
+}
+
+/**
+ * @brief adf4377_get_temp_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param temp - The die temperature in degrees Celsius.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_temp(struct adf4377_dev *dev, int16_t *temp)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_get_temp_unlocked(dev, temp);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Read the status registers with a single burst transfer.
+ * @param dev - The device structure.
+ * @param regs - REG0x49 to REG0x4F, ADF4377_STATUS_REGS bytes.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_get_status_unlocked(struct adf4377_dev *dev,
+					   uint8_t *regs)
+{
+	return adf4377_spi_read_burst(dev, ADF4377_STATUS_FIRST_REG, regs,
+				      ADF4377_STATUS_REGS);
+}
+
+/**
+ * @brief adf4377_get_status_unlocked() with the device lock held.
+ * @param dev - The device structure.
+ * @param regs - REG0x49 to REG0x4F, ADF4377_STATUS_REGS bytes.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_status(struct adf4377_dev *dev, uint8_t *regs)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_get_status_unlocked(dev, regs);
+
+	adf4377_unlock(dev);
+
+	return ret;
+}
+
+/**
+ * @brief Get the programmed output frequency.
+ * @param dev - The device structure.
+ * @param f_clk - The output frequency in Hz.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_frequency(struct adf4377_dev *dev, uint64_t *f_clk)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	*f_clk = dev->f_clk;
+
+	adf4377_unlock(dev);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get the programmed reference.
+ * @param dev - The device structure.
+ * @param clkin_freq - The input reference frequency in Hz.
+ * @param ref_doubler_en - The reference doubler state.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_reference(struct adf4377_dev *dev, uint32_t *clkin_freq,
+			      uint8_t *ref_doubler_en)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	*clkin_freq = dev->clkin_freq;
+	*ref_doubler_en = dev->ref_doubler_en;
+
+	adf4377_unlock(dev);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get the programmed charge pump current code.
+ * @param dev - The device structure.
+ * @param cp_i - The charge pump current code.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_cp_current(struct adf4377_dev *dev, uint8_t *cp_i)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	*cp_i = dev->cp_i;
+
+	adf4377_unlock(dev);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get the programmed output amplitude code.
+ * @param dev - The device structure.
+ * @param clkout_op - The output amplitude code.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_get_output_power(struct adf4377_dev *dev, uint8_t *clkout_op)
+{
+	int32_t ret;
+
+	ret = adf4377_lock(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	*clkout_op = dev->clkout_op;
+
+	adf4377_unlock(dev);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Check the health of a running device and recalibrate if needed.
+ *
+ * Meant to be called periodically. A single temperature conversion is run,
+ * the lock and reference status are taken from the status read ending it.
+ * The first call after a calibration records the calibration temperature.
+ * The VCO is recalibrated when the lock is lost or the die temperature has
+ * drifted by more than the configured threshold since the last calibration,
+ * as long as the reference is present. A recalibration leaves the fast
+ * hopping mode.
  * @param dev - The device structure.
- * @param reg_addr - The register address.
- * @param data - Data value to write.
- * @return Returns SUCCESS in case of success or negative error code otherwise.
+ * @param status - The monitor results, can be NULL.
+ * @return SUCCESS in case of success, negative error code otherwise.
  */
-int32_t adf4377_spi_write(struct adf4377_dev *dev, uint8_t reg_addr,
-			  uint8_t data)
+static int32_t adf4377_monitor_unlocked(struct adf4377_dev *dev,
+					struct adf4377_monitor_status *status)
 {
-	uint8_t buff[ADF4377_BUFF_SIZE_BYTES];
+	struct adf4377_monitor_status res = {0};
+	uint8_t reg;
+	int16_t drift;
+	int32_t ret;
 
-	if (dev->spi_desc->bit_order) {
-		buff[0] = bit_swap_constant_8(reg_addr);
-		buff[1] = bit_swap_constant_8(ADF4377_SPI_WRITE_CMD);
-		buff[2] = bit_swap_constant_8(data);
-	} else {
-		buff[0] = ADF4377_SPI_WRITE_CMD;
-		buff[1] = reg_addr;
-		buff[2] = data;
+	ret = adf4377_read_temp(dev, &res.temp, &reg);
+	if (ret != SUCCESS)
+		return ret;
+
+	res.locked = !!(reg & ADF4377_LOCKED_MSK);
+	res.ref_ok = !!(reg & ADF4377_REF_OK_MSK);
+
+	if (!dev->cal_temp_valid) {
+		dev->cal_temp = res.temp;
+		dev->cal_temp_valid = true;
+	}
+
+	drift = res.temp - dev->cal_temp;
+	if (drift < 0)
+		drift = -drift;
+
+	if (res.ref_ok && (!res.locked || drift >= dev->recal_temp_delta)) {
+		ret = adf4377_set_frequency_unlocked(dev, dev->f_clk);
+		if (ret != SUCCESS)
+			return ret;
+
+		dev->cal_temp = res.temp;
+		dev->cal_temp_valid = true;
+		res.locked = true;
+		res.recalibrated = true;
 	}
 
-	return spi_write_and_read(dev->spi_desc, buff, ADF4377_BUFF_SIZE_BYTES);
+	if (status)
+		*status = res;
+
+	return SUCCESS;
 }
 
 /**
- * @brief Update ADF4377 register.
+ * @brief adf4377_monitor_unlocked() with the device lock held.
  * @param dev - The device structure.
- * @param reg_addr - The register address.
- * @param mask - Mask for specific register bits to be updated.
- * @param data - Data read from the device.
- * @return Returns SUCCESS in case of success or negative error code otherwise.
+ * @param status - The monitor results, can be NULL.
+ * @return SUCCESS in case of success, negative error code otherwise.
  */
-int32_t adf4377_update(struct adf4377_dev *dev, uint8_t reg_addr,
-		       uint8_t mask, uint8_t data)
+int32_t adf4377_monitor(struct adf4377_dev *dev,
+			struct adf4377_monitor_status *status)
 {
-	uint8_t read_val;
 	int32_t ret;
 
-	ret = adf4377_spi_read(dev, reg_addr, &read_val);
+	ret = adf4377_lock(dev);
 	if (ret != SUCCESS)
 		return ret;
 
-	read_val &= ~mask;
-	read_val |= data;
+	ret = adf4377_monitor_unlocked(dev, status);
 
-	ret = adf4377_spi_write(dev, reg_addr, read_val);
+	adf4377_unlock(dev);
 
 	return ret;
 }
 
 /**
- * @brief Reads data from ADF4377 over SPI.
+ * @brief Queue the configuration of the device for a frequency plan, except
+ * the dividers of the plan and the calibration clocks.
  * @param dev - The device structure.
- * @param reg_addr - The register address.
- * @param data - Data read from the device.
- * @return Returns SUCCESS in case of success or negative error code otherwise.
+ * @param plan - The frequency plan.
+ * @param batch - The batch to queue the register updates in.
+ * @return None.
  */
-int32_t adf4377_spi_read(struct adf4377_dev *dev, uint8_t reg_addr,
-			 uint8_t *data)
+static void adf4377_queue_config(struct adf4377_dev *dev,
+				 const struct adf4377_freq_plan *plan,
+				 struct adf4377_batch *batch)
+{
+	/* Set Default Registers */
+	adf4377_set_default(dev, batch);
+
+	/* Update Charge Pump Current Value */
+	adf4377_batch_update(batch, ADF4377_REG(0x15), ADF4377_CP_I_MSK,
+			     ADF4377_CP_I(dev->cp_i));
+
+	adf4377_set_pfd(batch, plan);
+
+	/* Delay line updates are held until the next N_INT LSB write */
+	adf4377_batch_update(batch, ADF4377_REG(0x2A), ADF4377_DEL_CTRL_DB_MSK,
+			     ADF4377_DEL_CTRL_DB(ADF4377_DEL_CTRL_DB_EN));
+	adf4377_queue_delay(batch, dev->delay);
+
+	adf4377_queue_double_buffer(batch, dev->double_buffer);
+
+	adf4377_batch_update(batch, ADF4377_REG(0x1D), ADF4377_MUXOUT_MSK,
+			     ADF4377_MUXOUT(dev->muxout_default));
+
+	/* Power Up */
+	adf4377_batch_write(batch, ADF4377_REG(0x1a),
+			    ADF4377_PD_ALL(ADF4377_PD_ALL_N_OP) |
+			    ADF4377_PD_RDIV(ADF4377_PD_RDIV_N_OP) | ADF4377_PD_NDIV(ADF4377_PD_NDIV_N_OP) |
+			    ADF4377_PD_VCO(ADF4377_PD_VCO_N_OP) | ADF4377_PD_LD(ADF4377_PD_LD_N_OP) |
+			    ADF4377_PD_PFDCP(ADF4377_PD_PFDCP_N_OP) | ADF4377_PD_CLKOUT1(
+				    ADF4377_PD_CLKOUT1_N_OP) |
+			    ADF4377_PD_CLKOUT2(ADF4377_CHIP_INFO(dev)->num_outputs > 1 ?
+					       ADF4377_PD_CLKOUT2_N_OP : ADF4377_PD_CLKOUT2_PD));
+}
+
+/**
+ * @brief Queue the settings applied once the device is locked.
+ * @param dev - The device structure.
+ * @param batch - The batch to queue the register updates in.
+ * @return None.
+ */
+static void adf4377_queue_finish(struct adf4377_dev *dev,
+				 struct adf4377_batch *batch)
+{
+	adf4377_cal_clocks(batch, false);
+
+	/* Set output Amplitude */
+	adf4377_batch_update(batch, ADF4377_REG(0x19),
+			     ADF4377_CLKOUT2_OP_MSK | ADF4377_CLKOUT1_OP_MSK,
+			     ADF4377_CLKOUT1_OP(dev->clkout_op) | ADF4377_CLKOUT2_OP(dev->clkout_op));
+}
+
+/**
+ * @brief Configure the interface of a freshly reset device, check it and
+ * start the VCO calibration for the initial frequency plan.
+ * @param dev - The device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_setup_config(struct adf4377_dev *dev)
 {
 	int32_t ret;
-	uint8_t buff[ADF4377_BUFF_SIZE_BYTES];
+	uint8_t chip_type;
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	struct adf4377_freq_plan plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_SETUP_BATCH_SIZE];
 
-	if (dev->spi_desc->bit_order) {
-		buff[0] = bit_swap_constant_8(reg_addr);
-		buff[1] = bit_swap_constant_8(ADF4377_SPI_READ_CMD);
-		buff[2] = bit_swap_constant_8(ADF4377_SPI_DUMMY_DATA);
-	} else {
-		buff[0] = ADF4377_SPI_READ_CMD;
-		buff[1] = reg_addr;
-		buff[2] = ADF4377_SPI_DUMMY_DATA;
-	}
+	ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en,
+			       dev->f_clk, &plan);
+	if (ret != SUCCESS)
+		return ret;
 
-	ret = spi_write_and_read(dev->spi_desc, buff, ADF4377_BUFF_SIZE_BYTES);
-	if(ret != SUCCESS)
+	adf4377_set_phase(dev, ADF4377_PHASE_PROBE);
+
+	dev->addr_asc = ADF4377_ADDR_ASC_AUTO_DECR;
+
+	ret = adf4377_spi_write(dev, ADF4377_REG(0x00), adf4377_if_config(dev));
+	if (ret != SUCCESS)
 		return ret;
 
-	*data = buff[2];
+	/* Fill the Register Shadow Cache */
+	ret = adf4377_spi_read_burst(dev, ADF4377_REG(0x00), regs,
+				     ADF4377_REGMAP_SIZE);
+	if (ret != SUCCESS)
+		return ret;
 
-	return ret;
+	/* Check Chip Type */
+	chip_type = regs[ADF4377_REG(0x03)];
+	if (chip_type != ADF4377_CHIP_INFO(dev)->chip_type)
+		return -ENODEV;
+
+	/* Scratchpad Check */
+	ret = adf4377_check_scratchpad(dev);
+	if (ret != SUCCESS)
+		return ret;
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	adf4377_queue_config(dev, &plan, &batch);
+
+	adf4377_cal_clocks(&batch, true);
+
+	return adf4377_start_freq(dev, &plan, &batch);
 }
 
 /**
- * @brief ADF4377 SPI Scratchpad check.
+ * @brief Complete the setup of a locked device.
  * @param dev - The device structure.
- * @return Returns SUCCESS in case of success or negative error code.
+ * @return SUCCESS in case of success, negative error code otherwise.
  */
-int32_t adf4377_check_scratchpad(struct adf4377_dev *dev)
+static int32_t adf4377_setup_finish(struct adf4377_dev *dev)
+{
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_CAL_BATCH_SIZE];
+
+	adf4377_set_phase(dev, ADF4377_PHASE_PROGRAM);
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+
+	adf4377_queue_finish(dev, &batch);
+
+	return adf4377_batch_flush_unlocked(dev, &batch);
+}
+
+/**
+ * @brief Adopt a device already holding the target configuration.
+ *
+ * The register map is read with a single burst, assuming the interface
+ * configuration of a previous initialization, and compared with the complete
+ * configuration setup would program. On a match the device is taken over as
+ * is, without any write, so the output is not interrupted.
+ * @param dev - The device structure.
+ * @param adopted - Set to true if the device was adopted, false if it has to
+ * go through the full setup.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_warm_start(struct adf4377_dev *dev, bool *adopted)
 {
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	struct adf4377_freq_plan plan;
+	struct adf4377_batch batch;
+	struct adf4377_batch_entry entries[ADF4377_SETUP_BATCH_SIZE];
+	struct adf4377_batch_entry *entry;
+	uint8_t i;
 	int32_t ret;
-	uint8_t scratchpad;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x0A), ADF4377_SPI_SCRATCHPAD);
+	*adopted = false;
+
+	ret = adf4377_get_plan(dev, dev->clkin_freq, dev->ref_doubler_en,
+			       dev->f_clk, &plan);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_spi_read(dev, ADF4377_REG(0x0A), &scratchpad);
+	adf4377_set_phase(dev, ADF4377_PHASE_PROBE);
+
+	dev->addr_asc = ADF4377_ADDR_ASC_AUTO_DECR;
+
+	ret = adf4377_spi_read_burst(dev, ADF4377_REG(0x00), regs,
+				     ADF4377_REGMAP_SIZE);
 	if (ret != SUCCESS)
 		return ret;
 
-	if(scratchpad != ADF4377_SPI_SCRATCHPAD)
-		return FAILURE;
+	if (regs[ADF4377_REG(0x00)] != adf4377_if_config(dev) ||
+	    regs[ADF4377_REG(0x03)] != ADF4377_CHIP_INFO(dev)->chip_type ||
+	    regs[ADF4377_REG(0x0A)] != ADF4377_SPI_SCRATCHPAD ||
+	    (regs[ADF4377_REG(0x3D)] & ADF4377_O_VCO_CORE_MSK) ||
+	    !(regs[ADF4377_REG(0x49)] & ADF4377_LOCKED_MSK) ||
+	    (regs[ADF4377_REG(0x49)] & ADF4377_FSM_BUSY_MSK))
+		goto mismatch;
+
+	adf4377_batch_init(&batch, entries, ARRAY_SIZE(entries));
+	adf4377_queue_config(dev, &plan, &batch);
+	adf4377_queue_loop(dev, &batch, &plan);
+	adf4377_queue_freq(&batch, &plan);
+	adf4377_queue_finish(dev, &batch);
+	if (batch.ret != SUCCESS)
+		return batch.ret;
+
+	for (i = 0; i < batch.count; i++) {
+		entry = &batch.entries[i];
+		if ((regs[entry->reg_addr] & entry->mask) != entry->data)
+			goto mismatch;
+	}
+
+	dev->plan = plan;
+	dev->f_clk = plan.f_clk;
+	dev->ref_doubler_en = plan.ref_doubler_en;
+	dev->events_armed = true;
+	*adopted = true;
+
+	return SUCCESS;
+
+mismatch:
+	/* Nothing read is trusted, the full setup starts from scratch */
+	adf4377_regmap_invalidate(dev);
 
 	return SUCCESS;
 }
 
 /**
- * @brief Set default registers.
+ * Setup the device.
  * @param dev - The device structure.
- * @return Returns SUCCESS in case of success or negative error code.
+ * @return SUCCESS in case of success, negative error code otherwise.
  */
-static int32_t adf4377_set_default(struct adf4377_dev *dev)
+static int32_t adf4377_setup(struct adf4377_dev *dev)
 {
+	bool adopted;
 	int32_t ret;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x0f), ADF4377_R00F_RSV1);
+	if (dev->warm_start) {
+		ret = adf4377_warm_start(dev, &adopted);
+		if (ret != SUCCESS || adopted) {
+			adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+			return ret;
+		}
+	}
+
+	/* Software Reset */
+	ret = adf4377_soft_reset_unlocked(dev);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x1c), ADF4377_R01C_RSV1_MSK,
-			     ADF4377_R01C_RSV1(0x1));
+	ret = adf4377_setup_config(dev);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x1f), ADF4377_R01F_RSV1_MSK,
-			     ADF4377_R01F_RSV1(0x7));
+	ret = adf4377_wait_lock_unlocked(dev);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x20), ADF4377_R020_RSV1_MSK,
-			     ADF4377_R020_RSV1(0x1));
+	ret = adf4377_setup_finish(dev);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x21), ADF4377_R021_RSV1);
+	ret = adf4377_verify_auto(dev);
+
+	adf4377_set_phase(dev, ADF4377_PHASE_OTHER);
+
+	return ret;
+}
+
+/**
+ * @brief Initialize the ADF4377 descriptor in caller storage and acquire its
+ * platform resources, without accessing the device.
+ * @param dev - The device structure.
+ * @param init_param - The structure containing the device initial parameters.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_get_resources(struct adf4377_dev *dev,
+				     struct adf4377_init_param *init_param)
+{
+	int32_t ret;
+
+	if (!ADF4377_DEV_SUPPORTED(init_param->dev_id))
+		return -EINVAL;
+
+	if (init_param->muxout_select > field_get(ADF4377_MUXOUT_MSK,
+						  ADF4377_MUXOUT_MSK))
+		return -EINVAL;
+
+	if (init_param->delay < ADF4377_DELAY_MIN ||
+	    init_param->delay > ADF4377_DELAY_MAX)
+		return -EINVAL;
+
+	memset(dev, 0, sizeof(*dev));
+#ifdef ADF4377_STATS
+	adf4377_stats_reset(dev);
+#endif
+
+	dev->dev_id = init_param->dev_id;
+	dev->spi3wire = init_param->spi3wire;
+	dev->clkin_freq = init_param->clkin_freq;
+	dev->cp_i = init_param->cp_i;
+	dev->muxout_default = init_param->muxout_select;
+	dev->event_cb = init_param->event_cb;
+	dev->event_ctx = init_param->event_ctx;
+	dev->ref_doubler_en = init_param->ref_doubler_en;
+	dev->f_clk = init_param->f_clk;
+	dev->clkout_op = init_param->clkout_op;
+	dev->delay = init_param->delay;
+	dev->double_buffer = init_param->double_buffer;
+	dev->warm_start = init_param->warm_start;
+	dev->verify = init_param->verify;
+	dev->dev_lock = init_param->dev_lock;
+	dev->bus_lock = init_param->bus_lock;
+#ifdef ADF4377_ASYNC
+	dev->async_ops = init_param->async_ops;
+#endif
+#ifdef ADF4377_TRACE
+	dev->trace_timestamp = init_param->trace_timestamp;
+#endif
+	dev->recal_temp_delta = init_param->recal_temp_delta ?
+				init_param->recal_temp_delta : ADF4377_RECAL_TEMP_DELTA;
+	dev->freq_plans = init_param->freq_plans;
+	dev->num_freq_plans = init_param->num_freq_plans;
+	dev->solve_plan = init_param->solve_plan;
+	dev->reset_poll_us = init_param->reset_poll_us ? init_param->reset_poll_us :
+			     ADF4377_RESET_POLL_US;
+	dev->reset_timeout_us = init_param->reset_timeout_us ?
+				init_param->reset_timeout_us : ADF4377_RESET_TIMEOUT_US;
+
+	/* GPIO Chip Enable */
+	ret = gpio_get_optional(&dev->gpio_ce, init_param->gpio_ce_param);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_dev;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x22), ADF4377_R022_RSV1);
+	ret = gpio_direction_output(dev->gpio_ce, GPIO_HIGH);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_ce;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x23), ADF4377_R023_RSV1);
+	ret = gpio_get_optional(&dev->gpio_enclk1, init_param->gpio_enclk1_param);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_ce;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x25), ADF4377_R025_RSV1_MSK,
-			     ADF4377_R025_RSV1(0xB));
+	ret = gpio_direction_output(dev->gpio_enclk1, GPIO_HIGH);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_enclk1;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x2C), ADF4377_R02C_RSV1);
+	ret = gpio_get_optional(&dev->gpio_enclk2,
+				ADF4377_CHIP_INFO(dev)->num_outputs > 1 ?
+				init_param->gpio_enclk2_param : NULL);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_enclk1;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x31), ADF4377_R031_RSV1);
+	ret = gpio_direction_output(dev->gpio_enclk2, GPIO_HIGH);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_enclk2;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x32), ADF4377_R032_RSV1_MSK,
-			     ADF4377_R032_RSV1(0x9));
+	/* GPIO Lock Detect */
+	ret = gpio_get_optional(&dev->gpio_lkdet, init_param->gpio_lkdet_param);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_enclk2;
+
+	if (dev->gpio_lkdet) {
+		ret = gpio_direction_input(dev->gpio_lkdet);
+		if (ret != SUCCESS)
+			goto error_gpio_lkdet;
+	}
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x33), ADF4377_R033_RSV1);
+	/* GPIO MUXOUT */
+	ret = gpio_get_optional(&dev->gpio_muxout, init_param->gpio_muxout_param);
 	if (ret != SUCCESS)
-		return ret;
+		goto error_gpio_lkdet;
+
+	if (dev->gpio_muxout) {
+		ret = gpio_direction_input(dev->gpio_muxout);
+		if (ret != SUCCESS)
+			goto error_gpio_muxout;
+	}
+
+	/* SPI */
+#ifdef ADF4377_SPI_FIXED_BIT_ORDER
+	if (init_param->spi_init->bit_order != ADF4377_SPI_FIXED_BIT_ORDER) {
+		ret = -EINVAL;
+		goto error_gpio_muxout;
+	}
+#endif
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x34), ADF4377_R034_RSV1);
+	ret = spi_init(&dev->spi_desc, init_param->spi_init);
 	if (ret != SUCCESS)
+		goto error_gpio_muxout;
+
+	return ret;
+
+error_gpio_muxout:
+	gpio_remove(dev->gpio_muxout);
+
+error_gpio_lkdet:
+	gpio_remove(dev->gpio_lkdet);
+
+error_gpio_enclk2:
+	gpio_remove(dev->gpio_enclk2);
+
+error_gpio_enclk1:
+	gpio_remove(dev->gpio_enclk1);
+
+error_gpio_ce:
+	gpio_remove(dev->gpio_ce);
+
+error_dev:
+	return ret;
+}
+
+/**
+ * @brief Allocate the ADF4377 descriptor and its platform resources, without
+ * accessing the device.
+ * @param device - The device structure.
+ * @param init_param - The structure containing the device initial parameters.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_alloc(struct adf4377_dev **device,
+			     struct adf4377_init_param *init_param)
+{
+	int32_t ret;
+	struct adf4377_dev *dev;
+
+	dev = (struct adf4377_dev *)calloc(1, sizeof(*dev));
+	if (!dev)
+		return -ENOMEM;
+
+	ret = adf4377_get_resources(dev, init_param);
+	if (ret != SUCCESS) {
+		free(dev);
 		return ret;
+	}
+
+	*device = dev;
+
+	return ret;
+}
+
+/**
+ * @brief Initializes the ADF4377.
+ * @param device - The device structure.
+ * @param init_param - The structure containing the device initial parameters.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+int32_t adf4377_init(struct adf4377_dev **device,
+		     struct adf4377_init_param *init_param)
+{
+	int32_t ret;
+	struct adf4377_dev *dev;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x3A), ADF4377_R03A_RSV1);
+	ret = adf4377_alloc(&dev, init_param);
 	if (ret != SUCCESS)
 		return ret;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x3B), ADF4377_R03B_RSV1);
-	if (ret != SUCCESS)
+	ret = adf4377_setup(dev);
+	if (ret != SUCCESS) {
+		adf4377_remove(dev);
 		return ret;
+	}
+
+	*device = dev;
 
-	return adf4377_spi_write(dev, ADF4377_REG(0x42), ADF4377_R042_RSV1);
+	return ret;
 }
 
 /**
- * @brief Software reset.
- * @param dev - The device structure.
+ * @brief Initializes the ADF4377 in caller provided storage.
+ *
+ * Same as adf4377_init() without any heap allocation for the device
+ * descriptor, the storage must stay valid until adf4377_remove_static().
+ * @param dev - The device structure storage.
+ * @param init_param - The structure containing the device initial parameters.
  * @return Returns SUCCESS in case of success or negative error code.
  */
-int32_t adf4377_soft_reset(struct adf4377_dev *dev)
+int32_t adf4377_init_static(struct adf4377_dev *dev,
+			    struct adf4377_init_param *init_param)
 {
 	int32_t ret;
-	uint16_t timeout = 0xFFFF;
-	uint8_t data;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x00),
-			     ADF4377_SOFT_RESET_MSK | ADF4377_SOFT_RESET_R_MSK,
-			     ADF4377_SOFT_RESET(ADF4377_SOFT_RESET_EN) | ADF4377_SOFT_RESET_R(
-				     ADF4377_SOFT_RESET_EN));
+	ret = adf4377_get_resources(dev, init_param);
 	if (ret != SUCCESS)
 		return ret;
 
-	while(timeout) {
-		ret = adf4377_spi_read(dev, ADF4377_REG(0x00), &data);
-		if (ret != SUCCESS)
-			return ret;
-
-		if(!(data & ADF4377_SOFT_RESET(ADF4377_SOFT_RESET_EN)))
-			return SUCCESS;
-	}
+	ret = adf4377_setup(dev);
+	if (ret != SUCCESS)
+		adf4377_remove_static(dev);
 
-	return FAILURE;
+	return ret;
 }
 
 /**
- * Set the output frequency.
- * @param dev - The device structure.
- * @param freq - The output frequency.
- * @return SUCCESS in case of success, negative error code otherwise.
+ * @brief Replay a register image produced by adf4377_image_gen.
+ *
+ * The image is a sequence of records, each starting with its type:
+ * ADF4377_IMAGE_XFER carries a wire frame that is sent as is, already in the
+ * bit order and with the address direction of the target configuration,
+ * ADF4377_IMAGE_POLL carries a single register read frame that is repeated
+ * until (data & mask) == value or the timeout in us expires, and
+ * ADF4377_IMAGE_END terminates the image. No device descriptor is needed, the
+ * device is left in the same state as after adf4377_init() with the
+ * parameters the image was generated from.
+ * @param image - The register image.
+ * @param ops - The transport operations.
+ * @return Returns SUCCESS in case of success or negative error code.
  */
-static int32_t adf4377_set_freq(struct adf4377_dev *dev)
+int32_t adf4377_load_image(const uint8_t *image,
+			   const struct adf4377_image_ops *ops)
 {
+	uint8_t buff[ADF4377_BURST_SIZE_BYTES];
+	uint32_t timeout_us, elapsed_us;
+	const uint8_t *frame;
+	uint8_t len, mask, value;
 	int32_t ret;
 
-	dev->clkout_div_sel = 0;
+	if (!image || !ops || !ops->xfer || !ops->delay_us)
+		return -EINVAL;
 
-	if(ADF4377_CHECK_RANGE(dev->f_clk, CLKPN_FREQ))
-		return FAILURE;
+	while (true) {
+		switch (*image++) {
+		case ADF4377_IMAGE_END:
+			return SUCCESS;
+		case ADF4377_IMAGE_XFER:
+			len = *image++;
+			if (len <= ADF4377_SPI_INSTR_BYTES || len > sizeof(buff))
+				return -EINVAL;
 
-	dev->f_vco = dev->f_clk;
+			memcpy(buff, image, len);
+			image += len;
 
-	while (dev->f_vco < ADF4377_MIN_VCO_FREQ) {
-		dev->f_vco <<= 1;
-		dev->clkout_div_sel++;
-	}
+			ret = ops->xfer(ops->ctx, buff, len);
+			if (ret != SUCCESS)
+				return ret;
+			break;
+		case ADF4377_IMAGE_POLL:
+			mask = image[0];
+			value = image[1];
+			timeout_us = image[2] | (image[3] << 8);
+			frame = &image[4];
+			image += 4 + ADF4377_BUFF_SIZE_BYTES;
 
-	dev->n_int = dev->f_clk / dev->f_pfd;
+			for (elapsed_us = 0; ; elapsed_us += ADF4377_IMAGE_POLL_US) {
+				memcpy(buff, frame, ADF4377_BUFF_SIZE_BYTES);
+				ret = ops->xfer(ops->ctx, buff, ADF4377_BUFF_SIZE_BYTES);
+				if (ret != SUCCESS)
+					return ret;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x11),
-			     ADF4377_EN_RDBLR_MSK | ADF4377_N_INT_MSB_MSK,
-			     ADF4377_EN_RDBLR(dev->ref_doubler_en) | ADF4377_N_INT_MSB(dev->n_int >> 8));
-	if (ret != SUCCESS)
-		return ret;
+				if ((buff[2] & mask) == value)
+					break;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x12),
-			     ADF4377_R_DIV_MSK | ADF4377_CLKOUT_DIV_MSK,
-			     ADF4377_CLKOUT_DIV(dev->clkout_div_sel) | ADF4377_R_DIV(dev->ref_div_factor));
-	if (ret != SUCCESS)
-		return ret;
+				if (elapsed_us >= timeout_us)
+					return -ETIMEDOUT;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x10), ADF4377_N_INT_LSB(dev->n_int));
-	if (ret != SUCCESS)
-		return ret;
+				ops->delay_us(ops->ctx, ADF4377_IMAGE_POLL_US);
+			}
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+}
 
-	mdelay(100);
+/**
+ * @brief Busy wait on behalf of all the devices of a group.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices.
+ * @param us - The delay in us.
+ * @return None.
+ */
+static void adf4377_group_delay_us(struct adf4377_dev **devices,
+				   uint8_t num_devs, uint32_t us)
+{
+#if defined(ADF4377_STATS) || defined(ADF4377_TRACE)
+	uint8_t i;
 
-	return ret;
+	for (i = 0; i < num_devs; i++) {
+#ifdef ADF4377_STATS
+		devices[i]->stats.phase[devices[i]->phase].delay_us += us;
+#endif
+#ifdef ADF4377_TRACE
+		devices[i]->trace.time_us += us;
+#endif
+	}
+#endif
 
+	udelay(us);
 }
 
 /**
- * Setup the device.
- * @param dev - The device structure.
- * @return SUCCESS in case of success, negative error code otherwise.
+ * @brief Wait for lock on all the devices of a group at once.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices.
+ * @return Returns SUCCESS in case of success or negative error code.
  */
-static int32_t adf4377_setup(struct adf4377_dev *dev)
+static int32_t adf4377_group_wait_lock(struct adf4377_dev **devices,
+				       uint8_t num_devs)
 {
+	uint8_t done[DIV_ROUND_UP(ADF4377_GROUP_MAX_DEVS, 8)] = {0};
+	uint32_t elapsed = 0, poll_us = ADF4377_LOCK_POLL_US, timeout_us = 0;
+	uint8_t pending = num_devs, i;
+	bool locked;
 	int32_t ret;
-	uint8_t chip_type;
-	uint32_t f_div_rclk;
-	uint8_t dclk_div1, dclk_div2, dclk_mode;
-	uint16_t synth_lock_timeout, vco_alc_timeout, adc_clk_div, vco_band_div;
-
-	dev->ref_div_factor = 0;
 
-	/* Software Reset */
-	ret = adf4377_soft_reset(dev);
-	if (ret != SUCCESS)
-		return ret;
+	for (i = 0; i < num_devs; i++) {
+		adf4377_set_phase(devices[i], ADF4377_PHASE_LOCK);
+		poll_us += adf4377_lock_poll_us(devices[i]) - ADF4377_LOCK_POLL_US;
+		if (devices[i]->plan.lock_timeout_us > timeout_us)
+			timeout_us = devices[i]->plan.lock_timeout_us;
+	}
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x00),
-				ADF4377_LSB_FIRST_R(dev->spi_desc->bit_order) |
-				ADF4377_LSB_FIRST(dev->spi_desc->bit_order) |
-				ADF4377_SDO_ACTIVE_R(dev->spi3wire) |
-				ADF4377_SDO_ACTIVE(dev->spi3wire) |
-				ADF4377_ADDRESS_ASC_R(ADF4377_ADDR_ASC_AUTO_DECR) |
-				ADF4377_ADDRESS_ASC(ADF4377_ADDR_ASC_AUTO_DECR));
-	if (ret != SUCCESS)
-		return ret;
+	while (true) {
+		for (i = 0; i < num_devs; i++) {
+			if (done[i / 8] & BIT(i % 8))
+				continue;
 
-	/* Read Chip Type */
-	ret = adf4377_spi_read(dev, ADF4377_REG(0x03), &chip_type);
-	if (ret != SUCCESS)
-		return ret;
+			ret = adf4377_get_lock_unlocked(devices[i], &locked);
+			if (ret != SUCCESS)
+				return ret;
 
-	if (chip_type != ADF4377_CHIP_TYPE)
-		return ret;
+			if (locked) {
+				devices[i]->lock_time_us = elapsed;
+				adf4377_stats_lock(devices[i], elapsed);
+				devices[i]->events_armed = true;
+				done[i / 8] |= BIT(i % 8);
+				pending--;
+			}
+		}
 
-	/* Scratchpad Check */
-	ret = adf4377_check_scratchpad(dev);
-	if (ret != SUCCESS)
-		return ret;
+		if (!pending)
+			return SUCCESS;
 
-	/* Set Default Registers */
-	ret = adf4377_set_default(dev);
-	if (ret != SUCCESS)
-		return ret;
+		if (elapsed >= timeout_us)
+			return -ETIMEDOUT;
 
-	/* Update Charge Pump Current Value */
-	ret = adf4377_update(dev, ADF4377_REG(0x15), ADF4377_CP_I_MSK,
-			     ADF4377_CP_I(dev->cp_i));
-	if (ret != SUCCESS)
-		return ret;
+		adf4377_group_delay_us(devices, num_devs, ADF4377_LOCK_POLL_US);
+		elapsed += poll_us;
+	}
+}
 
-	/*Compute PFD */
-	if (!(dev->ref_doubler_en))
-		do {
-			dev->ref_div_factor++;
-			dev->f_pfd = dev->clkin_freq / dev->ref_div_factor;
-		} while (dev->f_pfd > ADF4377_MAX_FREQ_PFD);
-	else
-		dev->f_pfd = dev->clkin_freq * (1 + dev->ref_doubler_en);
+/**
+ * @brief Bring up a group of ADF4377 devices.
+ *
+ * Each setup phase is issued to all the devices before moving to the next
+ * one: the soft resets are polled together, the calibrations of all the
+ * devices run concurrently and a single lock wait covers the whole group,
+ * so the bring-up time is close to the one of a single device. Devices
+ * adopted by their warm start skip the reset and configuration phases.
+ * Devices with verification enabled are then verified as adf4377_init()
+ * does.
+ * @param devices - Array receiving the device structures.
+ * @param init_params - Array of device initial parameters.
+ * @param num_devs - Number of devices, at most ADF4377_GROUP_MAX_DEVS.
+ * @return Returns SUCCESS in case of success or negative error code. On error
+ * no device is left allocated.
+ */
+int32_t adf4377_group_init(struct adf4377_dev **devices,
+			   struct adf4377_init_param *init_params,
+			   uint8_t num_devs)
+{
+	uint8_t adopted[DIV_ROUND_UP(ADF4377_GROUP_MAX_DEVS, 8)] = {0};
+	uint16_t poll_us = UINT16_MAX;
+	uint8_t num_alloc, i;
+	bool busy, warm;
+	int32_t ret;
 
-	if(ADF4377_CHECK_RANGE(dev->f_pfd, FREQ_PFD))
-		return FAILURE;
+	if (!num_devs || num_devs > ADF4377_GROUP_MAX_DEVS)
+		return -EINVAL;
 
-	f_div_rclk = dev->f_pfd;
-
-	if (dev->f_pfd <= ADF4377_FREQ_PFD_80MHZ) {
-		dclk_div1 = ADF4377_DCLK_DIV1_1;
-		dclk_div2 = ADF4377_DCLK_DIV2_1;
-		dclk_mode = ADF4377_DCLK_MODE_DIS;
-	} else if (dev->f_pfd <= ADF4377_FREQ_PFD_125MHZ) {
-		dclk_div1 = ADF4377_DCLK_DIV1_1;
-		dclk_div2 = ADF4377_DCLK_DIV2_1;
-		dclk_mode = ADF4377_DCLK_MODE_EN;
-	} else if (dev->f_pfd <= ADF4377_FREQ_PFD_160MHZ) {
-		dclk_div1 = ADF4377_DCLK_DIV1_2;
-		dclk_div2 = ADF4377_DCLK_DIV2_1;
-		dclk_mode = ADF4377_DCLK_MODE_DIS;
-		f_div_rclk /= 2;
-	} else if (dev->f_pfd <= ADF4377_FREQ_PFD_250MHZ) {
-		dclk_div1 = ADF4377_DCLK_DIV1_2;
-		dclk_div2 = ADF4377_DCLK_DIV2_1;
-		dclk_mode = ADF4377_DCLK_MODE_EN;
-		f_div_rclk /= 2;
-	} else if (dev->f_pfd <= ADF4377_FREQ_PFD_320MHZ) {
-		dclk_div1 = ADF4377_DCLK_DIV1_2;
-		dclk_div2 = ADF4377_DCLK_DIV2_2;
-		dclk_mode = ADF4377_DCLK_MODE_DIS;
-		f_div_rclk /= 4;
-	} else {
-		dclk_div1 = ADF4377_DCLK_DIV1_2;
-		dclk_div2 = ADF4377_DCLK_DIV2_2;
-		dclk_mode = ADF4377_DCLK_MODE_EN;
-		f_div_rclk /= 4;
+	for (num_alloc = 0; num_alloc < num_devs; num_alloc++) {
+		ret = adf4377_alloc(&devices[num_alloc], &init_params[num_alloc]);
+		if (ret != SUCCESS)
+			goto error;
 	}
 
-	synth_lock_timeout = DIV_ROUND_UP(f_div_rclk, 50000);
-	vco_alc_timeout = DIV_ROUND_UP(f_div_rclk, 20000);
-	vco_band_div = DIV_ROUND_UP(f_div_rclk, 150000 * 16 * (1 << dclk_mode));
-	adc_clk_div = DIV_ROUND_UP((f_div_rclk / 400000 - 2), 4);
+	/* Warm Start */
+	for (i = 0; i < num_devs; i++) {
+		if (!devices[i]->warm_start)
+			continue;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x1C),
-			     ADF4377_EN_DNCLK_MSK | ADF4377_EN_DRCLK_MSK,
-			     ADF4377_EN_DNCLK(ADF4377_EN_DNCLK_ON) | ADF4377_EN_DRCLK(
-				     ADF4377_EN_DRCLK_ON));
-	if (ret != SUCCESS)
-		return ret;
+		ret = adf4377_warm_start(devices[i], &warm);
+		if (ret != SUCCESS)
+			goto error;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x11),
-			     ADF4377_EN_AUTOCAL_MSK | ADF4377_DCLK_DIV2_MSK,
-			     ADF4377_EN_AUTOCAL(ADF4377_VCO_CALIB_EN) | ADF4377_DCLK_DIV2(dclk_div2));
-	if (ret != SUCCESS)
-		return ret;
+		if (warm)
+			adopted[i / 8] |= BIT(i % 8);
+	}
 
-	ret = adf4377_update(dev, ADF4377_REG(0x2E),
-			     ADF4377_EN_ADC_CNV_MSK | ADF4377_EN_ADC_MSK | ADF4377_ADC_A_CONV_MSK,
-			     ADF4377_EN_ADC_CNV(ADF4377_EN_ADC_CNV_EN) | ADF4377_EN_ADC(
-				     ADF4377_EN_ADC_EN) | ADF4377_ADC_A_CONV(ADF4377_ADC_A_CONV_VCO_CALIB));
-	if (ret != SUCCESS)
-		return ret;
+	/* Software Reset */
+	for (i = 0; i < num_devs; i++) {
+		if (adopted[i / 8] & BIT(i % 8))
+			continue;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x20), ADF4377_EN_ADC_CLK_MSK,
-			     ADF4377_EN_ADC_CLK(ADF4377_EN_ADC_CLK_EN));
-	if (ret != SUCCESS)
-		return ret;
+		ret = adf4377_soft_reset_start(devices[i]);
+		if (ret != SUCCESS)
+			goto error;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x2F), ADF4377_DCLK_DIV1_MSK,
-			     ADF4377_DCLK_DIV1(dclk_div1));
-	if (ret != SUCCESS)
-		return ret;
+		if (devices[i]->reset_poll_us < poll_us)
+			poll_us = devices[i]->reset_poll_us;
+	}
 
-	ret = adf4377_update(dev, ADF4377_REG(0x24), ADF4377_DCLK_MODE_MSK,
-			     ADF4377_DCLK_MODE(dclk_mode));
-	if (ret != SUCCESS)
-		return ret;
+	do {
+		busy = false;
+		for (i = 0; i < num_devs; i++) {
+			if (!devices[i]->reset_polls)
+				continue;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x27),
-				ADF4377_SYNTH_LOCK_TO_LSB(synth_lock_timeout));
-	if (ret != SUCCESS)
-		return ret;
+			ret = adf4377_soft_reset_poll(devices[i]);
+			if (ret == -EAGAIN)
+				busy = true;
+			else if (ret != SUCCESS)
+				goto error;
+		}
 
-	ret = adf4377_update(dev, ADF4377_REG(0x28), ADF4377_SYNTH_LOCK_TO_MSB_MSK,
-			     ADF4377_SYNTH_LOCK_TO_MSB(synth_lock_timeout >> 8));
-	if (ret != SUCCESS)
-		return ret;
+		if (busy)
+			adf4377_group_delay_us(devices, num_devs, poll_us);
+	} while (busy);
 
-	ret = adf4377_spi_write(dev,ADF4377_REG(0x29),
-				ADF4377_VCO_ALC_TO_LSB(vco_alc_timeout));
-	if (ret != SUCCESS)
-		return ret;
+	for (i = 0; i < num_devs; i++) {
+		if (adopted[i / 8] & BIT(i % 8))
+			continue;
 
-	ret = adf4377_update(dev, ADF4377_REG(0x2A), ADF4377_VCO_ALC_TO_MSB_MSK,
-			     ADF4377_VCO_ALC_TO_MSB(vco_alc_timeout >> 8));
-	if (ret != SUCCESS)
-		return ret;
+		ret = adf4377_setup_config(devices[i]);
+		if (ret != SUCCESS)
+			goto error;
+	}
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x26),
-				ADF4377_VCO_BAND_DIV(vco_band_div));
+	ret = adf4377_group_wait_lock(devices, num_devs);
 	if (ret != SUCCESS)
-		return ret;
+		goto error;
 
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x2D),
-				ADF4377_ADC_CLK_DIV(adc_clk_div));
-	if (ret != SUCCESS)
-		return ret;
+	for (i = 0; i < num_devs; i++) {
+		ret = adf4377_setup_finish(devices[i]);
+		if (ret != SUCCESS)
+			goto error;
 
-	/* Power Up */
-	ret = adf4377_spi_write(dev, ADF4377_REG(0x1a),
-				ADF4377_PD_ALL(ADF4377_PD_ALL_N_OP) |
-				ADF4377_PD_RDIV(ADF4377_PD_RDIV_N_OP) | ADF4377_PD_NDIV(ADF4377_PD_NDIV_N_OP) |
-				ADF4377_PD_VCO(ADF4377_PD_VCO_N_OP) | ADF4377_PD_LD(ADF4377_PD_LD_N_OP) |
-				ADF4377_PD_PFDCP(ADF4377_PD_PFDCP_N_OP) | ADF4377_PD_CLKOUT1(
-					ADF4377_PD_CLKOUT1_N_OP) |
-				ADF4377_PD_CLKOUT2(ADF4377_PD_CLKOUT2_N_OP));
+		ret = adf4377_verify_auto(devices[i]);
+		if (ret != SUCCESS)
+			goto error;
 
-	ret = adf4377_set_freq(dev);
-	if (ret != SUCCESS)
-		return ret;
+		adf4377_set_phase(devices[i], ADF4377_PHASE_OTHER);
+	}
 
+	return SUCCESS;
 
+error:
+	while (num_alloc--)
+		adf4377_remove(devices[num_alloc]);
 
-	/* Disable EN_DNCLK, EN_DRCLK */
-	ret = adf4377_update(dev, ADF4377_REG(0x1C),
-			     ADF4377_EN_DNCLK_MSK | ADF4377_EN_DRCLK_MSK,
-			     ADF4377_EN_DNCLK(ADF4377_EN_DNCLK_OFF) | ADF4377_EN_DRCLK(
-				     ADF4377_EN_DRCLK_OFF));
-	if (ret != SUCCESS)
-		return ret;
+	return ret;
+}
+
+/**
+ * @brief Take the device locks of a group, in array order.
+ *
+ * Tasks locking overlapping groups must list the devices in the same order.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+static int32_t adf4377_group_lock(struct adf4377_dev **devices,
+				  uint8_t num_devs)
+{
+	int32_t ret;
+	uint8_t i;
 
-	/* Disable EN_ADC_CLK */
-	ret = adf4377_update(dev, ADF4377_REG(0x20), ADF4377_EN_ADC_CLK_MSK,
-			     ADF4377_EN_ADC_CLK(ADF4377_EN_ADC_CLK_DIS));
+	for (i = 0; i < num_devs; i++) {
+		ret = adf4377_lock(devices[i]);
+		if (ret != SUCCESS)
+			goto error;
+	}
 
-	/* Set output Amplitude */
-	ret = adf4377_update(dev, ADF4377_REG(0x19),
-			     ADF4377_CLKOUT2_OP_MSK | ADF4377_CLKOUT1_OP_MSK,
-			     ADF4377_CLKOUT1_OP(dev->clkout_op) | ADF4377_CLKOUT2_OP(dev->clkout_op));
+	return SUCCESS;
+
+error:
+	while (i--)
+		adf4377_unlock(devices[i]);
 
 	return ret;
 }
 
 /**
- * @brief Initializes the ADF4377.
- * @param device - The device structure.
- * @param init_param - The structure containing the device initial parameters.
+ * @brief Release the device locks of a group.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices.
+ * @return None.
+ */
+static void adf4377_group_unlock(struct adf4377_dev **devices,
+				 uint8_t num_devs)
+{
+	while (num_devs--)
+		adf4377_unlock(devices[num_devs]);
+}
+
+/**
+ * @brief Apply the staged delays of a group of devices together.
+ *
+ * The double buffer loads of all the devices are issued back to back, before
+ * any other access, so a group moves to its new output phases at once. The
+ * call returns when all the devices are locked again.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices, at most ADF4377_GROUP_MAX_DEVS.
  * @return Returns SUCCESS in case of success or negative error code.
  */
-int32_t adf4377_init(struct adf4377_dev **device,
-		     struct adf4377_init_param *init_param)
+static int32_t adf4377_group_sync_unlocked(struct adf4377_dev **devices,
+					  uint8_t num_devs)
 {
 	int32_t ret;
-	struct adf4377_dev *dev;
+	uint8_t i;
 
-	dev = (struct adf4377_dev *)calloc(1, sizeof(*dev));
-	if (!dev)
-		return -ENOMEM;
+	for (i = 0; i < num_devs; i++) {
+		ret = adf4377_sync_start(devices[i]);
+		if (ret != SUCCESS)
+			return ret;
+	}
 
-	dev->spi3wire = init_param->spi3wire;
-	dev->clkin_freq = init_param->clkin_freq;
-	dev->cp_i = init_param->cp_i;
-	dev->muxout_default = init_param->muxout_select;
-	dev->ref_doubler_en = init_param->ref_doubler_en;
-	dev->f_clk = init_param->f_clk;
-	dev->clkout_op = init_param->clkout_op;
+	for (i = 0; i < num_devs; i++) {
+		ret = adf4377_sync_end(devices[i]);
+		if (ret != SUCCESS)
+			return ret;
+	}
 
-	/* GPIO Chip Enable */
-	ret = gpio_get_optional(&dev->gpio_ce, init_param->gpio_ce_param);
-	if (ret != SUCCESS)
-		goto error_dev;
+	return adf4377_group_wait_lock(devices, num_devs);
+}
 
-	ret = gpio_direction_output(dev->gpio_ce, GPIO_HIGH);
-	if (ret != SUCCESS)
-		goto error_gpio_ce;
+/**
+ * @brief adf4377_group_sync_unlocked() with the device locks held.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices, at most ADF4377_GROUP_MAX_DEVS.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_group_sync(struct adf4377_dev **devices, uint8_t num_devs)
+{
+	int32_t ret;
 
-	ret = gpio_get_optional(&dev->gpio_enclk1, init_param->gpio_enclk1_param);
-	if (ret != SUCCESS)
-		goto error_gpio_ce;
+	if (!num_devs || num_devs > ADF4377_GROUP_MAX_DEVS)
+		return -EINVAL;
 
-	ret = gpio_direction_output(dev->gpio_enclk1, GPIO_HIGH);
+	ret = adf4377_group_lock(devices, num_devs);
 	if (ret != SUCCESS)
-		goto error_gpio_enclk1;
+		return ret;
 
-	ret = gpio_get_optional(&dev->gpio_enclk2, init_param->gpio_enclk2_param);
-	if (ret != SUCCESS)
-		goto error_gpio_enclk1;
+	ret = adf4377_group_sync_unlocked(devices, num_devs);
 
-	ret = gpio_direction_output(dev->gpio_enclk2, GPIO_HIGH);
-	if (ret != SUCCESS)
-		goto error_gpio_enclk2;
+	adf4377_group_unlock(devices, num_devs);
 
-	/* SPI */
-	ret = spi_init(&dev->spi_desc, init_param->spi_init);
-	if (ret != SUCCESS)
-		goto error_gpio_enclk2;
+	return ret;
+}
 
-	ret = adf4377_setup(dev);
-	if (ret != SUCCESS)
-		goto error_spi;
+/**
+ * @brief Align the output phases of a group of devices.
+ *
+ * The phase error of every device is measured by the caller provided
+ * callback and corrected through its delay lines, in steps of at most
+ * ADF4377_ALIGN_STEP_MAX so the loops stay locked while the outputs move.
+ * The corrections of all the devices are staged and applied together, with
+ * the device locks held, and the measurement, done without the locks, is
+ * repeated until all the errors are within tolerance.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices, at most ADF4377_GROUP_MAX_DEVS.
+ * @param param - Alignment parameters.
+ * @return Returns SUCCESS in case of success, -ERANGE if a device runs out of
+ * delay range, -ETIMEDOUT if the group is not aligned after the maximum
+ * number of iterations or another negative error code.
+ */
+int32_t adf4377_group_align(struct adf4377_dev **devices, uint8_t num_devs,
+			    const struct adf4377_align_param *param)
+{
+	int16_t target[ADF4377_GROUP_MAX_DEVS];
+	uint8_t moved[DIV_ROUND_UP(ADF4377_GROUP_MAX_DEVS, 8)];
+	int16_t error;
+	uint8_t iter, i;
+	bool aligned;
+	int32_t ret;
 
-	*device = dev;
+	if (!num_devs || num_devs > ADF4377_GROUP_MAX_DEVS || !param->measure)
+		return -EINVAL;
 
-	return ret;
+	for (iter = 0; ; iter++) {
+		memset(moved, 0, sizeof(moved));
+		aligned = true;
 
-error_spi:
-	spi_remove(dev->spi_desc);
+		for (i = 0; i < num_devs; i++) {
+			ret = param->measure(param->ctx, i, &error);
+			if (ret != SUCCESS)
+				return ret;
 
-error_gpio_enclk2:
-	gpio_remove(dev->gpio_enclk2);
+			if (error <= param->tolerance && error >= -param->tolerance)
+				continue;
 
-error_gpio_enclk1:
-	gpio_remove(dev->gpio_enclk1);
+			if (iter == param->max_iter)
+				return -ETIMEDOUT;
 
-error_gpio_ce:
-	gpio_remove(dev->gpio_ce);
+			target[i] = devices[i]->delay - error;
+			target[i] = max(min(target[i], ADF4377_DELAY_MAX), ADF4377_DELAY_MIN);
+			if (target[i] == devices[i]->delay)
+				return -ERANGE;
 
-error_dev:
-	free(dev);
+			target[i] = max(min(target[i],
+					    devices[i]->delay + ADF4377_ALIGN_STEP_MAX),
+					devices[i]->delay - ADF4377_ALIGN_STEP_MAX);
+			moved[i / 8] |= BIT(i % 8);
+			aligned = false;
+		}
 
-	return ret;
+		if (aligned)
+			return SUCCESS;
+
+		ret = adf4377_group_lock(devices, num_devs);
+		if (ret != SUCCESS)
+			return ret;
+
+		for (i = 0; i < num_devs; i++) {
+			if (!(moved[i / 8] & BIT(i % 8)))
+				continue;
+
+			ret = adf4377_stage_delay_unlocked(devices[i], target[i]);
+			if (ret != SUCCESS)
+				break;
+		}
+
+		if (ret == SUCCESS)
+			ret = adf4377_group_sync_unlocked(devices, num_devs);
+
+		adf4377_group_unlock(devices, num_devs);
+
+		if (ret != SUCCESS)
+			return ret;
+	}
 }
 
 /**
- * @brief Free resoulces allocated for ADF4377
+ * @brief Release the resources of an ADF4377 initialized with
+ * adf4377_init_static(), the descriptor storage itself is not freed.
  * @param dev - The device structure.
  * @return Returns SUCCESS in case of success or negative error code.
  */
-int32_t adf4377_remove(struct adf4377_dev *dev)
+int32_t adf4377_remove_static(struct adf4377_dev *dev)
 {
 	int32_t ret;
 
@@ -617,7 +5198,47 @@ int32_t adf4377_remove(struct adf4377_dev *dev)
 	if (ret != SUCCESS)
 		return ret;
 
+	ret = gpio_remove(dev->gpio_lkdet);
+	if (ret != SUCCESS)
+		return ret;
+
+	return gpio_remove(dev->gpio_muxout);
+}
+
+/**
+ * @brief Free resoulces allocated for ADF4377
+ * @param dev - The device structure.
+ * @return Returns SUCCESS in case of success or negative error code.
+ */
+int32_t adf4377_remove(struct adf4377_dev *dev)
+{
+	int32_t ret;
+
+	ret = adf4377_remove_static(dev);
+	if (ret != SUCCESS)
+		return ret;
+
 	free(dev);
 
 	return ret;
 }
+
+/**
+ * @brief Free the resources allocated for a group of ADF4377 devices.
+ * @param devices - The device structures.
+ * @param num_devs - Number of devices.
+ * @return Returns SUCCESS in case of success or the first negative error code.
+ */
+int32_t adf4377_group_remove(struct adf4377_dev **devices, uint8_t num_devs)
+{
+	int32_t ret = SUCCESS, err;
+	uint8_t i;
+
+	for (i = 0; i < num_devs; i++) {
+		err = adf4377_remove(devices[i]);
+		if (err != SUCCESS && ret == SUCCESS)
+			ret = err;
+	}
+
+	return ret;
+}
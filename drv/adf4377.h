@@ -43,6 +43,7 @@
 /******************************************************************************/
 /***************************** Include Files **********************************/
 #include <stdint.h>
+#include <stdbool.h>
 #include "spi.h"
 #include "gpio.h"
 #include "util.h"
@@ -106,6 +107,7 @@
 /* ADF4377 REG0003 Bit Definition */
 #define ADF4377_R003_RESERVED           (0x0 << 4)
 #define ADF4377_CHIP_TYPE               0x06
+#define ADF4378_CHIP_TYPE               0x06
 
 /* ADF4377 REG0004 Bit Definition */
 #define ADF4377_PRODUCT_ID_LSB          0x0005
@@ -243,6 +245,9 @@
 #define ADF4377_CLKOUT_INV_DIS          0x0
 #define ADF4377_CLKOUT_INV_EN           0x1
 
+#define ADF4377_N_DEL_MIN               0x00
+#define ADF4377_N_DEL_MAX               0x7F
+
 /* ADF4377 REG0018 Map */
 #define ADF4377_CMOS_OV_MSK				BIT(7)
 #define ADF4377_CMOS_OV(x)              field_prep(ADF4377_CMOS_OV_MSK, x)
@@ -657,6 +662,14 @@
 #define ADF4377_SPI_WRITE_CMD		    0x0
 #define ADF4377_SPI_READ_CMD		    BIT(7)
 #define ADF4377_BUFF_SIZE_BYTES		    3
+#define ADF4377_REGMAP_SIZE		    (ADF4377_REG(0x54) + 1)
+#define ADF4377_SPI_INSTR_BYTES		    2
+#define ADF4377_BURST_SIZE_BYTES	    (ADF4377_SPI_INSTR_BYTES + ADF4377_REGMAP_SIZE)
+#define ADF4377_BATCH_MAX_GAP		    2
+#define ADF4377_SETUP_BATCH_SIZE	    40
+#define ADF4377_CAL_BATCH_SIZE		    20
+#define ADF4377_BLEED_I_MAX		    0x3FF
+#define ADF4377_TUNE_PCT_MAX		    100
 #define ADF4377_MAX_VCO_FREQ		    12800000000ull /* Hz */
 #define ADF4377_MIN_VCO_FREQ		    6400000000ull /* Hz */
 #define ADF4377_MAX_REFIN_FREQ		    1000000000 /* Hz */
@@ -665,15 +678,62 @@
 #define ADF4377_MIN_FREQ_PFD		    3000000 /* Hz */
 #define ADF4377_MAX_CLKPN_FREQ		    ADF4377_MAX_VCO_FREQ /* Hz */
 #define ADF4377_MIN_CLKPN_FREQ		    (ADF4377_MIN_VCO_FREQ / 8) /* Hz */
+#define ADF4378_MAX_CLKPN_FREQ		    ADF4377_MAX_CLKPN_FREQ /* Hz */
+#define ADF4378_MIN_CLKPN_FREQ		    ADF4377_MIN_CLKPN_FREQ /* Hz */
 #define ADF4377_FREQ_PFD_80MHZ		    80000000
 #define ADF4377_FREQ_PFD_125MHZ		    125000000
 #define ADF4377_FREQ_PFD_160MHZ		    160000000
 #define ADF4377_FREQ_PFD_250MHZ		    250000000
 #define ADF4377_FREQ_PFD_320MHZ		    320000000
+#define ADF4377_LOCK_POLL_US		    10
+#define ADF4377_N_INT_MAX		    0xFFF
+#define ADF4377_PFD_RECIP_SHIFT		    40
+#define ADF4377_VERIFY_MAX_DIFFS	    8
+#define ADF4377_LOCK_TIMEOUT_MIN_US	    1000
+#define ADF4377_CAL_MAX_STEPS		    32
+#define ADF4377_RESET_POLL_US		    10
+#define ADF4377_RESET_TIMEOUT_US	    10000
+#define ADF4377_GROUP_MAX_DEVS		    16
+#define ADF4377_ADC_TIMEOUT_US		    1000
+#define ADF4377_RESTORE_FIRST_REG	    ADF4377_REG(0x10)
+#define ADF4377_RESTORE_LAST_REG	    ADF4377_REG(0x48)
+#define ADF4377_LOCK_HIST_BINS		    16
+#define ADF4377_LOCK_HIST_BIN_US	    100
+#define ADF4377_DELAY_MIN		    (-ADF4377_N_DEL_MAX)
+#define ADF4377_DELAY_MAX		    ADF4377_R_DEL_MAX
+#define ADF4377_ALIGN_STEP_MAX		    8
+#define ADF4377_RECAL_TEMP_DELTA	    40 /* degrees Celsius */
+#define ADF4377_IMAGE_POLL_US		    10
+#define ADF4377_IMAGE_TIMEOUT_MAX_US	    0xFFFF
+#define ADF4377_ASYNC_MAX_FRAMES	    16
+#define ADF4377_SWEEP_FIRST_REG		    ADF4377_REG(0x10)
+#define ADF4377_SWEEP_LAST_REG		    ADF4377_REG(0x14)
+#define ADF4377_SWEEP_REGS		    (ADF4377_SWEEP_LAST_REG - ADF4377_SWEEP_FIRST_REG + 1)
+#define ADF4377_SWEEP_FRAME_SIZE	    (2 * ADF4377_SPI_INSTR_BYTES + ADF4377_SWEEP_REGS)
+#define ADF4377_ASYNC_BUFF_SIZE		    (2 * ADF4377_BURST_SIZE_BYTES)
+#define ADF4377_STATUS_FIRST_REG	    ADF4377_REG(0x49)
+#define ADF4377_STATUS_LAST_REG		    ADF4377_REG(0x4F)
+#define ADF4377_STATUS_REGS		    (ADF4377_STATUS_LAST_REG - ADF4377_STATUS_FIRST_REG + 1)
+
+/* Trace Ring Buffer Records, a power of two */
+#ifndef ADF4377_TRACE_SIZE
+#define ADF4377_TRACE_SIZE		    256
+#endif
+
+/* Trace Record Flags */
+#define ADF4377_TRACE_READ		    BIT(0) /* read, write otherwise */
+#define ADF4377_TRACE_CONT		    BIT(1) /* same transfer as the previous record */
+
+/* Register Image Records */
+#define ADF4377_IMAGE_END		    0x00 /* end of image */
+#define ADF4377_IMAGE_XFER		    0x01 /* len, frame[len] */
+#define ADF4377_IMAGE_POLL		    0x02 /* mask, value, timeout LE16, frame[3] */
 
 /* ADF4377 Extra Definitions */
 #define ADF4377_SPI_SCRATCHPAD		    0xA5
 #define ADF4377_SPI_DUMMY_DATA		    0x00
+#define ADF4377_EVENT_LOCK_LOST		    BIT(0)
+#define ADF4377_EVENT_REF_LOST		    BIT(1)
 #define ADF4377_CHECK_RANGE(freq, range) \
 	((freq > ADF4377_MAX_ ## range) || (freq < ADF4377_MIN_ ## range))
 
@@ -690,11 +750,368 @@ enum adf4377_dev_id {
 	ADF4378
 };
 
+/**
+ * @struct adf4377_dclk_step
+ * @brief Calibration clock dividers for a PFD frequency bracket.
+ */
+struct adf4377_dclk_step {
+	/* Highest PFD Frequency of the Bracket */
+	uint32_t max_f_pfd;
+	/* Digital Calibration Clock Divider 1 */
+	uint8_t dclk_div1;
+	/* Digital Calibration Clock Divider 2 */
+	uint8_t dclk_div2;
+	/* Digital Calibration Clock Mode */
+	uint8_t dclk_mode;
+	/* Total Division of the PFD Frequency, as a power of two */
+	uint8_t div_shift;
+};
+
+/**
+ * @struct adf4377_reg_default
+ * @brief Register bits programmed to a fixed value at setup.
+ */
+struct adf4377_reg_default {
+	/* Register Address */
+	uint8_t reg_addr;
+	/* Programmed Bits */
+	uint8_t mask;
+	/* Programmed Value */
+	uint8_t data;
+};
+
+/**
+ * @struct adf4377_chip_info
+ * @brief Constants of a device variant.
+ */
+struct adf4377_chip_info {
+	/* Chip Type read back from REG0003 */
+	uint8_t chip_type;
+	/* Number of Clock Outputs */
+	uint8_t num_outputs;
+	/* Minimum Output Frequency in Hz */
+	uint64_t min_freq;
+	/* Maximum Output Frequency in Hz */
+	uint64_t max_freq;
+	/* Default Register Set */
+	const struct adf4377_reg_default *defaults;
+	/* Number of Default Registers */
+	uint8_t num_defaults;
+};
+
+/**
+ * @enum adf4377_phase
+ * @brief Driver phases the bus and delay statistics are accounted to.
+ */
+enum adf4377_phase {
+	/* Runtime accesses outside of the other phases */
+	ADF4377_PHASE_OTHER,
+	/* Soft reset and reset completion polling */
+	ADF4377_PHASE_RESET,
+	/* Interface setup, cache fill and device checks */
+	ADF4377_PHASE_PROBE,
+	/* Register programming, including the dividers and PFD setup */
+	ADF4377_PHASE_PROGRAM,
+	/* Wait for lock after a VCO calibration or hop */
+	ADF4377_PHASE_LOCK,
+	ADF4377_NUM_PHASES
+};
+
+/**
+ * @struct adf4377_phase_stats
+ * @brief Bus and delay statistics of a driver phase.
+ */
+struct adf4377_phase_stats {
+	/* SPI Transfers */
+	uint32_t xfers;
+	/* SPI Bytes */
+	uint32_t bytes;
+	/* Bus Time in us, computed from the SPI clock */
+	uint32_t bus_us;
+	/* Time Spent in Delays in us */
+	uint32_t delay_us;
+};
+
+/**
+ * @struct adf4377_stats
+ * @brief ADF4377 Instrumentation Data.
+ */
+struct adf4377_stats {
+	/* adf4377_spi_write() Calls */
+	uint32_t spi_write_calls;
+	/* adf4377_spi_read() Calls */
+	uint32_t spi_read_calls;
+	/* adf4377_update() Calls */
+	uint32_t update_calls;
+	/* Burst Read and Write Calls */
+	uint32_t burst_calls;
+	/* Per Phase Statistics */
+	struct adf4377_phase_stats phase[ADF4377_NUM_PHASES];
+	/* Number of Lock Time Measurements */
+	uint32_t lock_count;
+	/* Minimum Lock Time in us */
+	uint32_t lock_min_us;
+	/* Maximum Lock Time in us */
+	uint32_t lock_max_us;
+	/* Sum of the Lock Times in us */
+	uint64_t lock_sum_us;
+	/* Lock Time Histogram, ADF4377_LOCK_HIST_BIN_US wide bins */
+	uint32_t lock_hist[ADF4377_LOCK_HIST_BINS];
+};
+
+/**
+ * @struct adf4377_trace_rec
+ * @brief Register access recorded by the SPI trace.
+ */
+struct adf4377_trace_rec {
+	/* Time at the Start of the Transfer in us, from the timestamp source
+	 * or the driver time */
+	uint32_t time_us;
+	/* Register Address */
+	uint8_t reg_addr;
+	/* Written or Read Value */
+	uint8_t data;
+	/* ADF4377_TRACE_READ and ADF4377_TRACE_CONT */
+	uint8_t flags;
+	/* Transfer Status */
+	int8_t ret;
+};
+
+/**
+ * @struct adf4377_trace
+ * @brief ADF4377 SPI Trace Ring Buffer.
+ */
+struct adf4377_trace {
+	/* Recorded Register Accesses */
+	struct adf4377_trace_rec recs[ADF4377_TRACE_SIZE];
+	/* Index of the Next Record */
+	uint16_t head;
+	/* Number of Held Records */
+	uint16_t count;
+	/* Records Overwritten before being Read */
+	uint32_t lost;
+	/* Driver Time in us, the bus time of the transfers and the delays */
+	uint32_t time_us;
+	/* Records of the Transfer in Flight, the read data and status being
+	 * filled in once it is done */
+	uint8_t pending;
+};
+
+/**
+ * @struct adf4377_freq_plan
+ * @brief ADF4377 Frequency Plan, all the register values derived from the
+ * reference and output frequencies.
+ */
+struct adf4377_freq_plan {
+	/* Input Reference Clock */
+	uint32_t clkin_freq;
+	/* Reference doubler enable */
+	uint8_t ref_doubler_en;
+	/* Output frequency */
+	uint64_t f_clk;
+	/* PFD Frequency */
+	uint32_t f_pfd;
+	/* Output frequency of the VCO */
+	uint64_t f_vco;
+	/* Reference Divider */
+	uint8_t ref_div_factor;
+	/* Feedback Divider (N) */
+	uint16_t n_int;
+	/* CLKOUT Divider */
+	uint8_t clkout_div_sel;
+	/* Digital Calibration Clock Divider 1 */
+	uint8_t dclk_div1;
+	/* Digital Calibration Clock Divider 2 */
+	uint8_t dclk_div2;
+	/* Digital Calibration Clock Mode */
+	uint8_t dclk_mode;
+	/* Digital Calibration Clock Frequency */
+	uint32_t f_div_rclk;
+	/* Synthesizer Lock Timeout */
+	uint16_t synth_lock_timeout;
+	/* VCO ALC Timeout */
+	uint16_t vco_alc_timeout;
+	/* VCO Band Divider */
+	uint16_t vco_band_div;
+	/* ADC Clock Divider */
+	uint16_t adc_clk_div;
+	/* Lock Wait Budget in us */
+	uint32_t lock_timeout_us;
+	/* Loop Settings and Timeouts from adf4377_tune_plan(), programmed at
+	 * every retune to this plan */
+	bool tuned;
+	/* Charge Pump Current */
+	uint8_t cp_i;
+	/* Bleed Current Enable */
+	uint8_t bleed_en;
+	/* Bleed Current Polarity */
+	uint8_t bleed_pol;
+	/* Bleed Current */
+	uint16_t bleed_i;
+};
+
+/**
+ * @struct adf4377_tune_param
+ * @brief ADF4377 Lock Time Tuning Parameters.
+ */
+struct adf4377_tune_param {
+	/* Charge Pump Current Candidates, NULL for the current setting */
+	const uint8_t *cp_i;
+	/* Number of Charge Pump Current Candidates */
+	uint8_t num_cp_i;
+	/* Bleed Current Candidates, 0 disables the bleed current, NULL for
+	 * no bleed current */
+	const uint16_t *bleed_i;
+	/* Number of Bleed Current Candidates */
+	uint8_t num_bleed_i;
+	/* Bleed Current Polarity */
+	uint8_t bleed_pol;
+	/* Calibration Timeout Candidates, in percent of the computed
+	 * timeouts, NULL for the computed timeouts */
+	const uint8_t *timeout_pct;
+	/* Number of Calibration Timeout Candidates */
+	uint8_t num_timeout_pct;
+	/* Locks required from each candidate, at least one */
+	uint8_t trials;
+};
+
+/**
+ * @struct adf4377_align_param
+ * @brief ADF4377 Multi-chip Output Phase Alignment Parameters.
+ */
+struct adf4377_align_param {
+	/* Measure the output phase error of a group device against the common
+	 * phase reference, in delay steps, positive when the output lags */
+	int32_t (*measure)(void *ctx, uint8_t idx, int16_t *error);
+	/* Measurement Callback Context */
+	void *ctx;
+	/* Accepted Residual Phase Error in delay steps */
+	uint8_t tolerance;
+	/* Maximum Number of Measure and Adjust Iterations */
+	uint8_t max_iter;
+};
+
+/**
+ * @struct adf4377_monitor_status
+ * @brief ADF4377 Health Monitor Results.
+ */
+struct adf4377_monitor_status {
+	/* Die Temperature in degrees Celsius */
+	int16_t temp;
+	/* PLL Locked */
+	bool locked;
+	/* Reference Present */
+	bool ref_ok;
+	/* VCO Recalibrated by this check */
+	bool recalibrated;
+};
+
+/**
+ * @struct adf4377_image_ops
+ * @brief Bare transport used to replay a register image, so that it can run
+ * before the SPI and GPIO abstractions are initialized.
+ */
+struct adf4377_image_ops {
+	/* Full Duplex Transfer of a Wire Frame */
+	int32_t (*xfer)(void *ctx, uint8_t *data, uint16_t len);
+	/* Busy Wait in us */
+	void (*delay_us)(void *ctx, uint32_t us);
+	/* Transport Context */
+	void *ctx;
+};
+
+/**
+ * @struct adf4377_verify_diff
+ * @brief Register found different from the shadow cache by adf4377_verify().
+ */
+struct adf4377_verify_diff {
+	/* Register Address */
+	uint8_t reg_addr;
+	/* Programmed Value */
+	uint8_t expected;
+	/* Value read back */
+	uint8_t actual;
+};
+
+/**
+ * @struct adf4377_lock_ops
+ * @brief Mutual exclusion provided by the RTOS.
+ */
+struct adf4377_lock_ops {
+	/* Take the Lock, blocking */
+	int32_t (*lock)(void *ctx);
+	/* Release the Lock */
+	void (*unlock)(void *ctx);
+	/* Lock Context, e.g. the mutex handle */
+	void *ctx;
+};
+
+#ifdef ADF4377_ASYNC
+/**
+ * @struct adf4377_async_ops
+ * @brief Non-blocking SPI transport, typically a DMA or interrupt driven
+ * controller. done() is to be called from the completion interrupt, never
+ * from within submit().
+ */
+struct adf4377_async_ops {
+	/* Start a Full Duplex Transfer, data stays owned by the driver */
+	int32_t (*submit)(void *ctx, uint8_t *data, uint16_t len,
+			  void (*done)(void *arg, int32_t status), void *arg);
+	/* Optional, call fn(arg) from a timer once us have elapsed, spacing the
+	 * lock status polls by ADF4377_LOCK_POLL_US, back to back if NULL */
+	int32_t (*schedule)(void *ctx, uint32_t us, void (*fn)(void *arg),
+			    void *arg);
+	/* Transport Context */
+	void *ctx;
+};
+
+/**
+ * @struct adf4377_async_job
+ * @brief Prepared frames of a non-blocking job and its progress.
+ */
+struct adf4377_async_job {
+	/* Wire Frames, back to back */
+	uint8_t buff[ADF4377_ASYNC_BUFF_SIZE];
+	/* Length of each Frame */
+	uint16_t frame_len[ADF4377_ASYNC_MAX_FRAMES];
+	/* Number of Frames */
+	uint8_t num_frames;
+	/* Bytes used in buff */
+	uint16_t len;
+	/* Next Frame to send */
+	uint8_t frame;
+	/* Offset of the next Frame in buff */
+	uint16_t pos;
+	/* Frames are recorded instead of sent */
+	bool recording;
+	/* Wait for lock before sending the frames from lock_frame on */
+	bool lock_wait;
+	/* First Frame sent once locked */
+	uint8_t lock_frame;
+	/* Lock Status Polls left */
+	uint32_t lock_polls;
+	/* Lock Status Poll Frame */
+	uint8_t poll[ADF4377_BUFF_SIZE_BYTES];
+	/* Frequency Plan committed on completion */
+	struct adf4377_freq_plan plan;
+	/* plan is valid */
+	bool plan_valid;
+	/* Completion Callback */
+	void (*done)(void *ctx, int32_t status);
+	/* Completion Callback Context */
+	void *done_ctx;
+	/* Job in Progress */
+	volatile bool busy;
+};
+#endif
+
 /**
  * @struct adf4377_init_param
  * @brief ADF4377 Initialization Parameters structure.
  */
 struct adf4377_init_param {
+	/* Device ID */
+	enum adf4377_dev_id dev_id;
 	/* SPI Initialization parameters */
 	struct spi_init_param	*spi_init;
 	/* GPIO Chip Enable */
@@ -703,6 +1120,10 @@ struct adf4377_init_param {
 	struct gpio_init_param	*gpio_enclk1_param;
 	/* GPIO ENCLK2 */
 	struct gpio_init_param	*gpio_enclk2_param;
+	/* GPIO Lock Detect */
+	struct gpio_init_param	*gpio_lkdet_param;
+	/* GPIO MUXOUT, optional */
+	struct gpio_init_param	*gpio_muxout_param;
 	/* SPI 3-Wire */
 	uint8_t spi3wire;
 	/* Input Reference Clock */
@@ -717,6 +1138,47 @@ struct adf4377_init_param {
 	uint8_t ref_doubler_en;
 	/* Output Amplitude */
 	uint8_t	clkout_op;
+	/* Optional Precomputed Frequency Plans */
+	const struct adf4377_freq_plan *freq_plans;
+	/* Number of Precomputed Frequency Plans */
+	uint8_t num_freq_plans;
+	/* Select the Doubler and Reference Divider with adf4377_solve_plan(),
+	 * ref_doubler_en is then ignored */
+	bool solve_plan;
+	/* Soft Reset Poll Interval in us, 0 for default */
+	uint16_t reset_poll_us;
+	/* Soft Reset Time Budget in us, 0 for default */
+	uint32_t reset_timeout_us;
+	/* Reference to Output Delay in delay steps, positive values delay the
+	 * reference path (R_DEL), negative ones the feedback path (N_DEL) */
+	int16_t delay;
+	/* Hold Divider, DCLK and VCO Override Updates until the N_INT LSB Write */
+	bool double_buffer;
+	/* Temperature Drift triggering a Recalibration, 0 for default */
+	uint8_t recal_temp_delta;
+	/* Lock and Reference Loss Callback, called from adf4377_irq_handler() */
+	void (*event_cb)(void *ctx, uint32_t events);
+	/* Lock and Reference Loss Callback Context */
+	void *event_ctx;
+	/* Adopt a device already holding the configuration instead of resetting it */
+	bool warm_start;
+	/* Verify the whole configuration after init and every retune */
+	bool verify;
+	/* Optional Device Lock, taken once per public call, need not be recursive */
+	const struct adf4377_lock_ops *dev_lock;
+	/* Optional SPI Bus Lock, shared by all the devices on the bus */
+	const struct adf4377_lock_ops *bus_lock;
+#ifdef ADF4377_ASYNC
+	/* Optional Non-blocking Transport for the asynchronous jobs, owning the
+	 * SPI bus while a job runs, so not usable together with bus_lock */
+	const struct adf4377_async_ops *async_ops;
+#endif
+#ifdef ADF4377_TRACE
+	/* Optional Trace Timestamp Source in us, e.g. a free running timer.
+	 * Without it the records hold the driver time, which only counts the
+	 * bus time of the transfers and the requested delays */
+	uint32_t (*trace_timestamp)(void);
+#endif
 };
 
 /**
@@ -724,6 +1186,8 @@ struct adf4377_init_param {
  * @brief ADF4377 Device Descriptor.
  */
 struct adf4377_dev {
+	/* Device ID */
+	enum adf4377_dev_id dev_id;
 	/* SPI Descriptor */
 	struct spi_desc		*spi_desc;
 	/* GPIO ENCLK1 */
@@ -732,14 +1196,19 @@ struct adf4377_dev {
 	struct gpio_desc	*gpio_enclk2;
 	/* GPIO Chip Enable */
 	struct gpio_desc	*gpio_ce;
+	/* GPIO Lock Detect */
+	struct gpio_desc	*gpio_lkdet;
+	/* VCO Calibration started and not yet seen done in REG0x49, LKDET may
+	 * still show the lock of the previous frequency */
+	bool cal_pending;
+	/* GPIO MUXOUT */
+	struct gpio_desc	*gpio_muxout;
 	/* SPI 3-Wire */
 	uint8_t spi3wire;
-	/* PFD Frequency */
-	uint32_t f_pfd;
+	/* Address Ascension used for Streaming Transfers */
+	uint8_t addr_asc;
 	/* Output frequency */
 	uint64_t f_clk;
-	/* Output frequency of the VCO */
-	uint64_t f_vco;
 	/* Input Reference Clock */
 	uint32_t clkin_freq;
 	/* Charge Pump Current */
@@ -748,14 +1217,189 @@ struct adf4377_dev {
 	uint8_t muxout_default;
 	/* Reference doubler enable */
 	uint8_t	ref_doubler_en;
-	/* Reference Divider */
-	uint32_t ref_div_factor;
-	/* CLKOUT Divider */
-	uint8_t clkout_div_sel;
-	/* Feedback Divider (N) */
-	uint16_t n_int;
+	/* Active Frequency Plan */
+	struct adf4377_freq_plan plan;
+	/* Last Computed Frequency Plan, its PFD dependent part is reused by
+	 * the retunes at the same reference */
+	struct adf4377_freq_plan pfd_plan;
+	/* Reciprocal of the PFD Frequency of pfd_plan, scaled by
+	 * 2^ADF4377_PFD_RECIP_SHIFT */
+	uint32_t pfd_recip;
+	/* Precomputed Frequency Plans */
+	const struct adf4377_freq_plan *freq_plans;
+	/* Number of Precomputed Frequency Plans */
+	uint8_t num_freq_plans;
+	/* Frequency Plans from adf4377_solve_plan() */
+	bool solve_plan;
+	/* Soft Reset Poll Interval in us */
+	uint16_t reset_poll_us;
+	/* Soft Reset Time Budget in us */
+	uint32_t reset_timeout_us;
+	/* Soft Reset Polls Left */
+	uint32_t reset_polls;
+	/* Last Measured Lock Time in us */
+	uint32_t lock_time_us;
+	/* Manual VCO Core and Band Selection active */
+	bool hop_mode;
 	/* Output Amplitude */
 	uint8_t	clkout_op;
+	/* Programmed Reference to Output Delay in delay steps */
+	int16_t delay;
+	/* Double Buffered Retune active */
+	bool double_buffer;
+	/* Temperature Drift triggering a Recalibration */
+	uint8_t recal_temp_delta;
+	/* Die Temperature at the last Calibration */
+	int16_t cal_temp;
+	/* Die Temperature at the last Calibration recorded */
+	bool cal_temp_valid;
+	/* Lock and Reference Loss Callback */
+	void (*event_cb)(void *ctx, uint32_t events);
+	/* Lock and Reference Loss Callback Context */
+	void *event_ctx;
+	/* Lock and Reference Loss Events armed */
+	volatile bool events_armed;
+	/* Warm Start enabled */
+	bool warm_start;
+	/* Verification after init and every retune enabled */
+	bool verify;
+	/* Mismatches found by the last automatic verification */
+	struct adf4377_verify_diff verify_diffs[ADF4377_VERIFY_MAX_DIFFS];
+	/* Number of Mismatches found by the last automatic verification */
+	uint8_t num_verify_diffs;
+	/* Device Lock */
+	const struct adf4377_lock_ops *dev_lock;
+	/* SPI Bus Lock */
+	const struct adf4377_lock_ops *bus_lock;
+	/* SPI Bus Lock held by the current batch flush */
+	bool bus_held;
+#ifdef ADF4377_ASYNC
+	/* Non-blocking Transport */
+	const struct adf4377_async_ops *async_ops;
+	/* Current Asynchronous Job */
+	struct adf4377_async_job job;
+#endif
+#ifdef ADF4377_STATS
+	/* Current Instrumentation Phase */
+	enum adf4377_phase phase;
+	/* Instrumentation Data */
+	struct adf4377_stats stats;
+#endif
+#ifdef ADF4377_TRACE
+	/* SPI Trace */
+	struct adf4377_trace trace;
+	/* Trace Timestamp Source */
+	uint32_t (*trace_timestamp)(void);
+#endif
+	/* Register Shadow Cache */
+	uint8_t regmap[ADF4377_REGMAP_SIZE];
+	/* Valid Register Shadow Cache Entries Bitmap */
+	uint8_t regmap_valid[DIV_ROUND_UP(ADF4377_REGMAP_SIZE, 8)];
+};
+
+/**
+ * @struct adf4377_batch_entry
+ * @brief Register update queued in a transaction batch.
+ */
+struct adf4377_batch_entry {
+	/* Register Address */
+	uint8_t reg_addr;
+	/* Register Bits to be Updated */
+	uint8_t mask;
+	/* Register Data */
+	uint8_t data;
+};
+
+/**
+ * @struct adf4377_batch
+ * @brief ADF4377 Register Transaction Batch.
+ */
+struct adf4377_batch {
+	/* Caller Provided Entries, sorted by register address */
+	struct adf4377_batch_entry *entries;
+	/* Number of Available Entries */
+	uint8_t size;
+	/* Number of Queued Entries */
+	uint8_t count;
+	/* First Queueing Error */
+	int32_t ret;
+};
+
+/**
+ * @struct adf4377_hop_entry
+ * @brief Calibrated output frequency for fast hopping.
+ */
+struct adf4377_hop_entry {
+	/* Output frequency */
+	uint64_t f_clk;
+	/* Feedback Divider (N) */
+	uint16_t n_int;
+	/* CLKOUT Divider */
+	uint8_t clkout_div_sel;
+	/* VCO Core selected by the calibration */
+	uint8_t vco_core;
+	/* VCO Band selected by the calibration */
+	uint8_t vco_band;
+};
+
+/**
+ * @struct adf4377_sweep_step
+ * @brief Prestaged sweep step.
+ */
+struct adf4377_sweep_step {
+	/* Wire Frames, only the registers changed since the previous step */
+	uint8_t buff[ADF4377_SWEEP_FRAME_SIZE];
+	/* Frame Lengths, the second one is the separate N_INT LSB write used
+	 * in address ascending mode, 0 otherwise */
+	uint8_t len[2];
+	/* Hop Register Values after the step */
+	uint8_t regs[ADF4377_SWEEP_REGS];
+	/* Dwell Time in us */
+	uint32_t dwell_us;
+};
+
+/**
+ * @struct adf4377_sweep_param
+ * @brief Sweep Parameters.
+ */
+struct adf4377_sweep_param {
+	/* Calibrated Hop Table, one entry per step */
+	const struct adf4377_hop_entry *table;
+	/* Dwell Time of each step in us */
+	const uint32_t *dwell_us;
+	/* Caller Storage for the Prestaged Steps, one per table entry */
+	struct adf4377_sweep_step *steps;
+	/* Number of Steps */
+	uint8_t num_steps;
+	/* Hold a step until the previous one is locked */
+	bool gate_lock;
+	/* Restart from the first step after the last one */
+	bool repeat;
+};
+
+/**
+ * @struct adf4377_sweep
+ * @brief Sweep State.
+ */
+struct adf4377_sweep {
+	/* Device Structure */
+	struct adf4377_dev *dev;
+	/* Calibrated Hop Table */
+	const struct adf4377_hop_entry *table;
+	/* Prestaged Steps */
+	struct adf4377_sweep_step *steps;
+	/* Number of Steps */
+	uint8_t num_steps;
+	/* Current Step */
+	uint8_t step;
+	/* Hold a step until the previous one is locked */
+	bool gate_lock;
+	/* Restart from the first step after the last one */
+	bool repeat;
+	/* Ticks held waiting for lock */
+	uint32_t lock_misses;
+	/* Sweep running */
+	volatile bool active;
 };
 
 /******************************************************************************/
@@ -770,13 +1414,195 @@ int32_t adf4377_spi_write(struct adf4377_dev *dev, uint8_t reg_addr,
 int32_t adf4377_spi_read(struct adf4377_dev *dev, uint8_t reg_addr,
 			 uint8_t *data);
 
+/** ADF4377 SPI Burst Write */
+int32_t adf4377_spi_write_burst(struct adf4377_dev *dev, uint8_t reg_addr,
+				const uint8_t *data, uint8_t len);
+
+/** ADF4377 SPI Burst Read */
+int32_t adf4377_spi_read_burst(struct adf4377_dev *dev, uint8_t reg_addr,
+			       uint8_t *data, uint8_t len);
+
 /* ADF4377 Register Update */
 int32_t adf4377_update(struct adf4377_dev *dev, uint8_t reg_addr,
 		       uint8_t mask, uint8_t data);
 
+/** ADF4377 Transaction Batch Initialization */
+void adf4377_batch_init(struct adf4377_batch *batch,
+			struct adf4377_batch_entry *entries, uint8_t size);
+
+/** ADF4377 Queue Register Write */
+int32_t adf4377_batch_write(struct adf4377_batch *batch, uint8_t reg_addr,
+			    uint8_t data);
+
+/** ADF4377 Queue Register Update */
+int32_t adf4377_batch_update(struct adf4377_batch *batch, uint8_t reg_addr,
+			     uint8_t mask, uint8_t data);
+
+/** ADF4377 Transaction Batch Flush */
+int32_t adf4377_batch_flush(struct adf4377_dev *dev,
+			    struct adf4377_batch *batch);
+
+#ifdef ADF4377_ASYNC
+/** ADF4377 Non-blocking Transaction Batch Flush */
+int32_t adf4377_batch_flush_async(struct adf4377_dev *dev,
+				  struct adf4377_batch *batch,
+				  void (*done)(void *ctx, int32_t status),
+				  void *ctx);
+#endif
+
+/* ADF4377 Register Shadow Cache Invalidation */
+void adf4377_regmap_invalidate(struct adf4377_dev *dev);
+
+#ifdef ADF4377_STATS
+/** ADF4377 Instrumentation Data Reset */
+void adf4377_stats_reset(struct adf4377_dev *dev);
+#endif
+
+#ifdef ADF4377_TRACE
+/** ADF4377 SPI Trace Reset */
+void adf4377_trace_reset(struct adf4377_dev *dev);
+
+/** ADF4377 SPI Trace Read */
+uint16_t adf4377_trace_read(struct adf4377_dev *dev,
+			    struct adf4377_trace_rec *recs, uint16_t max);
+
+/** ADF4377 SPI Trace Replay */
+int32_t adf4377_trace_replay(struct adf4377_dev *dev,
+			     const struct adf4377_trace_rec *recs, uint16_t num,
+			     bool timed, uint16_t *mismatches);
+#endif
+
 /* ADF4377 Scratchpad check */
 int32_t adf4377_check_scratchpad(struct adf4377_dev *dev);
 
+/** ADF4377 Register Map Dump */
+int32_t adf4377_regmap_dump(struct adf4377_dev *dev, uint8_t *regs);
+
+/** ADF4377 Configuration Verification */
+int32_t adf4377_verify(struct adf4377_dev *dev,
+		       struct adf4377_verify_diff *diffs, uint8_t max_diffs,
+		       uint8_t *num_diffs);
+
+/** ADF4377 Register Map Restore */
+int32_t adf4377_regmap_restore(struct adf4377_dev *dev, const uint8_t *regs);
+
+/** ADF4377 Start Software Reset */
+int32_t adf4377_soft_reset_start(struct adf4377_dev *dev);
+
+/** ADF4377 Poll Software Reset Completion */
+int32_t adf4377_soft_reset_poll(struct adf4377_dev *dev);
+
+/** ADF4377 Software Reset */
+int32_t adf4377_soft_reset(struct adf4377_dev *dev);
+
+/** ADF4377 Frequency Plan Computation */
+int32_t adf4377_compute_plan(uint32_t clkin_freq, uint8_t ref_doubler_en,
+			     uint64_t f_clk, struct adf4377_freq_plan *plan);
+
+/** ADF4377 Fastest Settling Frequency Plan */
+int32_t adf4377_solve_plan(uint32_t clkin_freq, uint64_t f_clk,
+			   struct adf4377_freq_plan *plan);
+
+/** ADF4377 Frequency Plan Lookup */
+const struct adf4377_freq_plan *adf4377_find_plan(
+	const struct adf4377_freq_plan *plans, uint8_t num_plans,
+	uint32_t clkin_freq, uint8_t ref_doubler_en, uint64_t f_clk);
+
+/** ADF4377 Get Lock Status */
+int32_t adf4377_get_lock(struct adf4377_dev *dev, bool *locked);
+
+/** ADF4377 Lock and Reference Loss Interrupt Handler */
+void adf4377_irq_handler(void *ctx, uint32_t event, void *extra);
+
+/** ADF4377 Wait for Lock */
+int32_t adf4377_wait_lock(struct adf4377_dev *dev);
+
+/** ADF4377 Set Output Frequency */
+int32_t adf4377_set_frequency(struct adf4377_dev *dev, uint64_t f_clk);
+
+/** ADF4377 Lock Time Tuning */
+int32_t adf4377_tune_plan(struct adf4377_dev *dev, uint64_t f_clk,
+			  const struct adf4377_tune_param *param,
+			  struct adf4377_freq_plan *plan);
+
+#ifdef ADF4377_ASYNC
+/** ADF4377 Non-blocking Output Frequency Change */
+int32_t adf4377_set_frequency_async(struct adf4377_dev *dev, uint64_t f_clk,
+				    void (*done)(void *ctx, int32_t status),
+				    void *ctx);
+#endif
+
+/** ADF4377 Set Reference */
+int32_t adf4377_set_reference(struct adf4377_dev *dev, uint32_t clkin_freq,
+			      uint8_t ref_doubler_en);
+
+/** ADF4377 Set Charge Pump Current */
+int32_t adf4377_set_cp_current(struct adf4377_dev *dev, uint8_t cp_i);
+
+/** ADF4377 Set Output Amplitude */
+int32_t adf4377_set_output_power(struct adf4377_dev *dev, uint8_t clkout_op);
+
+/** ADF4377 Set Double Buffered Retune */
+int32_t adf4377_set_double_buffer(struct adf4377_dev *dev, bool enable);
+
+/** ADF4377 Get Die Temperature */
+int32_t adf4377_get_temp(struct adf4377_dev *dev, int16_t *temp);
+
+/** ADF4377 Read the Status Registers */
+int32_t adf4377_get_status(struct adf4377_dev *dev, uint8_t *regs);
+
+/** ADF4377 Get Output Frequency */
+int32_t adf4377_get_frequency(struct adf4377_dev *dev, uint64_t *f_clk);
+
+/** ADF4377 Get Reference */
+int32_t adf4377_get_reference(struct adf4377_dev *dev, uint32_t *clkin_freq,
+			      uint8_t *ref_doubler_en);
+
+/** ADF4377 Get Charge Pump Current */
+int32_t adf4377_get_cp_current(struct adf4377_dev *dev, uint8_t *cp_i);
+
+/** ADF4377 Get Output Amplitude */
+int32_t adf4377_get_output_power(struct adf4377_dev *dev, uint8_t *clkout_op);
+
+/** ADF4377 Stage Reference to Output Delay */
+int32_t adf4377_stage_delay(struct adf4377_dev *dev, int16_t delay);
+
+/** ADF4377 Apply Staged Delay */
+int32_t adf4377_sync(struct adf4377_dev *dev);
+
+/** ADF4377 Set Reference to Output Delay */
+int32_t adf4377_set_delay(struct adf4377_dev *dev, int16_t delay);
+
+/** ADF4377 Health Monitor */
+int32_t adf4377_monitor(struct adf4377_dev *dev,
+			struct adf4377_monitor_status *status);
+
+/** ADF4377 Hop Table Calibration */
+int32_t adf4377_hop_table_calibrate(struct adf4377_dev *dev,
+				    const uint64_t *freqs,
+				    struct adf4377_hop_entry *table, uint8_t num);
+
+/** ADF4377 Hop to a Calibrated Frequency */
+int32_t adf4377_hop(struct adf4377_dev *dev,
+		    const struct adf4377_hop_entry *entry);
+
+/** ADF4377 Leave Hopping Mode */
+int32_t adf4377_hop_exit(struct adf4377_dev *dev);
+
+/** ADF4377 Sweep Preparation */
+int32_t adf4377_sweep_prepare(struct adf4377_dev *dev,
+			      struct adf4377_sweep *sweep,
+			      const struct adf4377_sweep_param *param);
+
+/** ADF4377 Sweep Start */
+int32_t adf4377_sweep_start(struct adf4377_sweep *sweep, uint32_t *dwell_us);
+
+/** ADF4377 Sweep Step, called from the Timer Interrupt */
+int32_t adf4377_sweep_tick(struct adf4377_sweep *sweep, uint32_t *dwell_us);
+
+/** ADF4377 Sweep Stop */
+void adf4377_sweep_stop(struct adf4377_sweep *sweep);
+
 /** ADF4377 Initialization */
 int32_t adf4377_init(struct adf4377_dev **device,
 		     struct adf4377_init_param *init_param);
@@ -784,4 +1610,30 @@ int32_t adf4377_init(struct adf4377_dev **device,
 /** ADF4377 Resources Deallocation */
 int32_t adf4377_remove(struct adf4377_dev *dev);
 
+/** ADF4377 Initialization in Caller Storage */
+int32_t adf4377_init_static(struct adf4377_dev *dev,
+			    struct adf4377_init_param *init_param);
+
+/** ADF4377 Resources Release for Caller Storage */
+int32_t adf4377_remove_static(struct adf4377_dev *dev);
+
+/** ADF4377 Register Image Replay */
+int32_t adf4377_load_image(const uint8_t *image,
+			   const struct adf4377_image_ops *ops);
+
+/** ADF4377 Group Initialization */
+int32_t adf4377_group_init(struct adf4377_dev **devices,
+			   struct adf4377_init_param *init_params,
+			   uint8_t num_devs);
+
+/** ADF4377 Group Synchronized Delay Update */
+int32_t adf4377_group_sync(struct adf4377_dev **devices, uint8_t num_devs);
+
+/** ADF4377 Group Output Phase Alignment */
+int32_t adf4377_group_align(struct adf4377_dev **devices, uint8_t num_devs,
+			    const struct adf4377_align_param *param);
+
+/** ADF4377 Group Resources Deallocation */
+int32_t adf4377_group_remove(struct adf4377_dev **devices, uint8_t num_devs);
+
 #endif /* ADF4377_H_ */
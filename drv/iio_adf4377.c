@@ -41,13 +41,783 @@
 /******************************************************************************/
 /***************************** Include Files **********************************/
 /******************************************************************************/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include "iio_adf4377.h"
+#include "error.h"
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/**
+ * @brief Read a register through the IIO debug interface.
+ * @param device - The IIO device structure.
+ * @param reg - Register address.
+ * @param readval - Register value.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_iio_reg_read(void *device, uint32_t reg,
+				    uint32_t *readval)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t data;
+	int32_t ret;
+
+	ret = adf4377_spi_read(iio_dev->dev, reg, &data);
+	if (ret != SUCCESS)
+		return ret;
+
+	*readval = data;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Write a register through the IIO debug interface.
+ * @param device - The IIO device structure.
+ * @param reg - Register address.
+ * @param writeval - Register value.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_iio_reg_write(void *device, uint32_t reg,
+				     uint32_t writeval)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+
+	return adf4377_spi_write(iio_dev->dev, reg, writeval);
+}
+
+/**
+ * @brief Show the output frequency.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_frequency(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint64_t f_clk;
+	int32_t ret;
+
+	ret = adf4377_get_frequency(iio_dev->dev, &f_clk);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%"PRIu64, f_clk);
+}
+
+/**
+ * @brief Retune the output frequency.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_store_frequency(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	int32_t ret;
+
+	ret = adf4377_set_frequency(iio_dev->dev, strtoull(buf, NULL, 0));
+	if (ret != SUCCESS)
+		return ret;
+
+	return len;
+}
+
+/**
+ * @brief Show the output amplitude code.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_output_power(void *device, char *buf,
+		size_t len, const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t clkout_op;
+	int32_t ret;
+
+	ret = adf4377_get_output_power(iio_dev->dev, &clkout_op);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%"PRIu8, clkout_op);
+}
+
+/**
+ * @brief Set the output amplitude code.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_store_output_power(void *device, char *buf,
+		size_t len, const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	int32_t ret;
+
+	ret = adf4377_set_output_power(iio_dev->dev, strtoul(buf, NULL, 0));
+	if (ret != SUCCESS)
+		return ret;
+
+	return len;
+}
+
+/**
+ * @brief Show the input reference frequency.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_reference(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint32_t clkin_freq;
+	uint8_t ref_doubler_en;
+	int32_t ret;
+
+	ret = adf4377_get_reference(iio_dev->dev, &clkin_freq, &ref_doubler_en);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%"PRIu32, clkin_freq);
+}
+
+/**
+ * @brief Change the input reference frequency.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_store_reference(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint32_t clkin_freq;
+	uint8_t ref_doubler_en;
+	int32_t ret;
+
+	ret = adf4377_get_reference(iio_dev->dev, &clkin_freq, &ref_doubler_en);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_set_reference(iio_dev->dev, strtoul(buf, NULL, 0),
+				    ref_doubler_en);
+	if (ret != SUCCESS)
+		return ret;
+
+	return len;
+}
+
+/**
+ * @brief Show the charge pump current code.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_cp_current(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t cp_i;
+	int32_t ret;
+
+	ret = adf4377_get_cp_current(iio_dev->dev, &cp_i);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%"PRIu8, cp_i);
+}
+
+/**
+ * @brief Set the charge pump current code.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_store_cp_current(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	int32_t ret;
+
+	ret = adf4377_set_cp_current(iio_dev->dev, strtoul(buf, NULL, 0));
+	if (ret != SUCCESS)
+		return ret;
+
+	return len;
+}
+
+/**
+ * @brief Show the PLL lock status.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_lock(void *device, char *buf, size_t len,
+				     const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	bool locked;
+	int32_t ret;
+
+	ret = adf4377_get_lock(iio_dev->dev, &locked);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%d", locked);
+}
+
+/**
+ * @brief Show the die temperature.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_temp(void *device, char *buf, size_t len,
+				     const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	int16_t temp;
+	int32_t ret;
+
+	ret = adf4377_get_temp(iio_dev->dev, &temp);
+	if (ret != SUCCESS)
+		return ret;
+
+	return snprintf(buf, len, "%"PRId16, temp);
+}
+
+/**
+ * @brief Show the die temperature scale, in milli degrees Celsius.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_temp_scale(void *device, char *buf, size_t len,
+		const struct iio_ch_info *channel, intptr_t priv)
+{
+	return snprintf(buf, len, "1000");
+}
+
+/**
+ * @brief Dump the whole register map as a hex string, register 0x00 first.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_regmap(void *device, char *buf, size_t len,
+				       const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	uint8_t i;
+	int32_t ret;
+
+	if (len < ADF4377_IIO_REGMAP_STR_LEN + 1)
+		return -EINVAL;
+
+	ret = adf4377_regmap_dump(iio_dev->dev, regs);
+	if (ret != SUCCESS)
+		return ret;
+
+	for (i = 0; i < ADF4377_REGMAP_SIZE; i++)
+		snprintf(buf + 2 * i, 3, "%02x", regs[i]);
+
+	return ADF4377_IIO_REGMAP_STR_LEN;
+}
+
+/**
+ * @brief Restore the configuration from a hex string in the format returned
+ * by adf4377_iio_show_regmap().
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_store_regmap(void *device, char *buf, size_t len,
+					const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	char byte[3] = {0};
+	char *end;
+	uint8_t i;
+	int32_t ret;
+
+	if (len < ADF4377_IIO_REGMAP_STR_LEN)
+		return -EINVAL;
+
+	for (i = 0; i < ADF4377_REGMAP_SIZE; i++) {
+		memcpy(byte, buf + 2 * i, 2);
+		regs[i] = strtoul(byte, &end, 16);
+		if (end != byte + 2)
+			return -EINVAL;
+	}
+
+	ret = adf4377_regmap_restore(iio_dev->dev, regs);
+	if (ret != SUCCESS)
+		return ret;
+
+	return len;
+}
+
+#ifdef ADF4377_STATS
+/**
+ * @brief Show the instrumentation data.
+ *
+ * One line per driver phase with the SPI transfers, bytes, bus time and delay
+ * time in us, followed by the lock time count, min, max and average in us and
+ * the lock time histogram.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written, negative error code otherwise.
+ */
+static ssize_t adf4377_iio_show_stats(void *device, char *buf, size_t len,
+				      const struct iio_ch_info *channel, intptr_t priv)
+{
+	static const char * const phase_names[ADF4377_NUM_PHASES] = {
+		[ADF4377_PHASE_OTHER] = "other",
+		[ADF4377_PHASE_RESET] = "reset",
+		[ADF4377_PHASE_PROBE] = "probe",
+		[ADF4377_PHASE_PROGRAM] = "program",
+		[ADF4377_PHASE_LOCK] = "lock",
+	};
+	struct adf4377_iio_dev *iio_dev = device;
+	struct adf4377_stats *stats = &iio_dev->dev->stats;
+	struct adf4377_phase_stats *phase;
+	size_t pos = 0;
+	uint8_t i;
+
+	for (i = 0; i < ADF4377_NUM_PHASES && pos < len; i++) {
+		phase = &stats->phase[i];
+		pos += snprintf(buf + pos, len - pos,
+				"%s %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu32"\n",
+				phase_names[i], phase->xfers, phase->bytes,
+				phase->bus_us, phase->delay_us);
+	}
+
+	if (pos < len)
+		pos += snprintf(buf + pos, len - pos,
+				"lock_time %"PRIu32" %"PRIu32" %"PRIu32" %"PRIu64"\n",
+				stats->lock_count,
+				stats->lock_count ? stats->lock_min_us : 0,
+				stats->lock_max_us,
+				stats->lock_count ? stats->lock_sum_us / stats->lock_count : 0);
+
+	if (pos < len)
+		pos += snprintf(buf + pos, len - pos, "lock_hist");
+
+	for (i = 0; i < ADF4377_LOCK_HIST_BINS && pos < len; i++)
+		pos += snprintf(buf + pos, len - pos, " %"PRIu32, stats->lock_hist[i]);
+
+	if (pos >= len)
+		return -ENOMEM;
+
+	return pos;
+}
+
+/**
+ * @brief Clear the instrumentation data, whatever the written value.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read.
+ */
+static ssize_t adf4377_iio_store_stats(void *device, char *buf, size_t len,
+				       const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+
+	adf4377_stats_reset(iio_dev->dev);
+
+	return len;
+}
+#endif
+
+#ifdef ADF4377_TRACE
+/**
+ * @brief Show the SPI trace.
+ *
+ * The oldest records are taken out of the trace, as many as fit in the
+ * buffer, one line per record with the driver time in us, the register
+ * address and value in hex, the flags and the transfer status. Reading again
+ * continues with the next records, until an empty read.
+ * @param device - The IIO device structure.
+ * @param buf - Output buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters written.
+ */
+static ssize_t adf4377_iio_show_trace(void *device, char *buf, size_t len,
+				      const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	struct adf4377_trace_rec rec;
+	size_t pos = 0;
+
+	while (len - pos > ADF4377_IIO_TRACE_LINE_LEN &&
+	       adf4377_trace_read(iio_dev->dev, &rec, 1))
+		pos += snprintf(buf + pos, len - pos, "%"PRIu32" %02x %02x %u %d\n",
+				rec.time_us, rec.reg_addr, rec.data, rec.flags,
+				rec.ret);
+
+	return pos;
+}
+
+/**
+ * @brief Clear the SPI trace, whatever the written value.
+ * @param device - The IIO device structure.
+ * @param buf - Input buffer.
+ * @param len - Buffer length.
+ * @param channel - Channel information.
+ * @param priv - Attribute private data.
+ * @return Number of characters read.
+ */
+static ssize_t adf4377_iio_store_trace(void *device, char *buf, size_t len,
+				       const struct iio_ch_info *channel, intptr_t priv)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+
+	adf4377_trace_reset(iio_dev->dev);
+
+	return len;
+}
+#endif
+
+/**
+ * @brief Start a buffered status capture.
+ * @param device - The IIO device structure.
+ * @param mask - Active scan elements mask.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_iio_prepare_transfer(void *device, uint32_t mask)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+
+	iio_dev->active_mask = mask;
+	iio_dev->seq = 0;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Stop the buffered status capture.
+ * @param device - The IIO device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_iio_end_transfer(void *device)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+
+	iio_dev->active_mask = 0;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Capture status samples.
+ *
+ * Each sample holds the active scan elements in scan index order, each one
+ * aligned to its storage size. The status registers are fetched with a single
+ * burst read per sample, the temperature adds one ADC conversion when active.
+ * @param device - The IIO device structure.
+ * @param buff - Sample buffer.
+ * @param nb_samples - Number of samples.
+ * @return Number of samples captured, negative error code otherwise.
+ */
+static int32_t adf4377_iio_read_dev(void *device, void *buff,
+				    uint32_t nb_samples)
+{
+	struct adf4377_iio_dev *iio_dev = device;
+	uint8_t regs[ADF4377_STATUS_REGS];
+	uint16_t val[ADF4377_IIO_SCAN_TIMESTAMP];
+	uint8_t *sample = buff;
+	int16_t temp = 0;
+	uint32_t i, ts;
+	size_t offset;
+	uint8_t ch;
+	int32_t ret;
+
+	for (i = 0; i < nb_samples; i++) {
+		if (iio_dev->active_mask & BIT(ADF4377_IIO_SCAN_TEMP)) {
+			ret = adf4377_get_temp(iio_dev->dev, &temp);
+			if (ret != SUCCESS)
+				return ret;
+		}
+
+		ret = adf4377_get_status(iio_dev->dev, regs);
+		if (ret != SUCCESS)
+			return ret;
+
+		val[ADF4377_IIO_SCAN_LOCKED] = field_get(ADF4377_LOCKED_MSK, regs[0]);
+		val[ADF4377_IIO_SCAN_FSM_BUSY] = field_get(ADF4377_FSM_BUSY_MSK, regs[0]);
+		val[ADF4377_IIO_SCAN_VCO_BAND] = regs[ADF4377_STATUS_LAST_REG -
+							   ADF4377_STATUS_FIRST_REG];
+		val[ADF4377_IIO_SCAN_TEMP] = temp;
+		ts = iio_dev->get_timestamp ? iio_dev->get_timestamp() : iio_dev->seq;
+		iio_dev->seq++;
+
+		offset = 0;
+		for (ch = 0; ch < ADF4377_IIO_SCAN_TIMESTAMP; ch++) {
+			if (!(iio_dev->active_mask & BIT(ch)))
+				continue;
+
+			memcpy(sample + offset, &val[ch], sizeof(val[ch]));
+			offset += sizeof(val[ch]);
+		}
+
+		if (iio_dev->active_mask & BIT(ADF4377_IIO_SCAN_TIMESTAMP)) {
+			offset = (offset + sizeof(ts) - 1) & ~(sizeof(ts) - 1);
+			memcpy(sample + offset, &ts, sizeof(ts));
+			offset += sizeof(ts);
+		}
+
+		sample += offset;
+	}
+
+	return nb_samples;
+}
+
+/**
+ * @brief Initialize the ADF4377 IIO device.
+ * @param iio_dev - The IIO device structure.
+ * @param init_param - The structure containing the IIO initial parameters.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_iio_init(struct adf4377_iio_dev **iio_dev,
+			 struct adf4377_iio_init_param *init_param)
+{
+	struct adf4377_iio_dev *desc;
+
+	if (!init_param->dev)
+		return -EINVAL;
+
+	desc = (struct adf4377_iio_dev *)calloc(1, sizeof(*desc));
+	if (!desc)
+		return -ENOMEM;
+
+	desc->dev = init_param->dev;
+	desc->get_timestamp = init_param->get_timestamp;
+
+	*iio_dev = desc;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Free the resources allocated for the ADF4377 IIO device.
+ * @param iio_dev - The IIO device structure.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_iio_remove(struct adf4377_iio_dev *iio_dev)
+{
+	free(iio_dev);
+
+	return SUCCESS;
+}
 
 /******************************************************************************/
 /*************************** Types Definitions ********************************/
 /******************************************************************************/
 
+static struct iio_attribute adf4377_iio_out_attrs[] = {
+	{
+		.name = "frequency",
+		.show = adf4377_iio_show_frequency,
+		.store = adf4377_iio_store_frequency,
+	},
+	{
+		.name = "output_power",
+		.show = adf4377_iio_show_output_power,
+		.store = adf4377_iio_store_output_power,
+	},
+	END_ATTRIBUTES_ARRAY
+};
+
+static struct iio_attribute adf4377_iio_temp_attrs[] = {
+	{
+		.name = "raw",
+		.show = adf4377_iio_show_temp,
+	},
+	{
+		.name = "scale",
+		.show = adf4377_iio_show_temp_scale,
+	},
+	END_ATTRIBUTES_ARRAY
+};
+
+static struct iio_attribute adf4377_iio_dev_attrs[] = {
+	{
+		.name = "reference_frequency",
+		.show = adf4377_iio_show_reference,
+		.store = adf4377_iio_store_reference,
+	},
+	{
+		.name = "charge_pump_current",
+		.show = adf4377_iio_show_cp_current,
+		.store = adf4377_iio_store_cp_current,
+	},
+	{
+		.name = "lock_status",
+		.show = adf4377_iio_show_lock,
+	},
+	{
+		.name = "regmap",
+		.show = adf4377_iio_show_regmap,
+		.store = adf4377_iio_store_regmap,
+	},
+#ifdef ADF4377_STATS
+	{
+		.name = "stats",
+		.show = adf4377_iio_show_stats,
+		.store = adf4377_iio_store_stats,
+	},
+#endif
+#ifdef ADF4377_TRACE
+	{
+		.name = "trace",
+		.show = adf4377_iio_show_trace,
+		.store = adf4377_iio_store_trace,
+	},
+#endif
+	END_ATTRIBUTES_ARRAY
+};
+
+static struct scan_type adf4377_iio_scan_status = {
+	.sign = 'u',
+	.realbits = 8,
+	.storagebits = 16,
+	.shift = 0,
+	.is_big_endian = false
+};
+
+static struct scan_type adf4377_iio_scan_temp = {
+	.sign = 's',
+	.realbits = 16,
+	.storagebits = 16,
+	.shift = 0,
+	.is_big_endian = false
+};
+
+static struct scan_type adf4377_iio_scan_timestamp = {
+	.sign = 'u',
+	.realbits = 32,
+	.storagebits = 32,
+	.shift = 0,
+	.is_big_endian = false
+};
+
+static struct iio_channel adf4377_iio_channels[] = {
+	{
+		.name = "altvoltage0",
+		.ch_type = IIO_ALTVOLTAGE,
+		.channel = 0,
+		.scan_index = -1,
+		.attributes = adf4377_iio_out_attrs,
+		.ch_out = true,
+		.indexed = true,
+	},
+	{
+		.name = "locked",
+		.ch_type = IIO_COUNT,
+		.channel = 0,
+		.scan_index = ADF4377_IIO_SCAN_LOCKED,
+		.scan_type = &adf4377_iio_scan_status,
+		.indexed = true,
+	},
+	{
+		.name = "fsm_busy",
+		.ch_type = IIO_COUNT,
+		.channel = 1,
+		.scan_index = ADF4377_IIO_SCAN_FSM_BUSY,
+		.scan_type = &adf4377_iio_scan_status,
+		.indexed = true,
+	},
+	{
+		.name = "vco_band",
+		.ch_type = IIO_COUNT,
+		.channel = 2,
+		.scan_index = ADF4377_IIO_SCAN_VCO_BAND,
+		.scan_type = &adf4377_iio_scan_status,
+		.indexed = true,
+	},
+	{
+		.name = "temp0",
+		.ch_type = IIO_TEMP,
+		.channel = 0,
+		.scan_index = ADF4377_IIO_SCAN_TEMP,
+		.scan_type = &adf4377_iio_scan_temp,
+		.attributes = adf4377_iio_temp_attrs,
+		.indexed = true,
+	},
+	{
+		.name = "timestamp",
+		.ch_type = IIO_COUNT,
+		.channel = 3,
+		.scan_index = ADF4377_IIO_SCAN_TIMESTAMP,
+		.scan_type = &adf4377_iio_scan_timestamp,
+		.indexed = true,
+	},
+};
+
 struct iio_device const adf4377_iio_descriptor = {
-	.debug_reg_read = (int32_t (*)())adf4377_spi_read,
-	.debug_reg_write = (int32_t (*)())adf4377_spi_write,
+	.num_ch = ARRAY_SIZE(adf4377_iio_channels),
+	.channels = adf4377_iio_channels,
+	.attributes = adf4377_iio_dev_attrs,
+	.prepare_transfer = adf4377_iio_prepare_transfer,
+	.end_transfer = adf4377_iio_end_transfer,
+	.read_dev = adf4377_iio_read_dev,
+	.debug_reg_read = adf4377_iio_reg_read,
+	.debug_reg_write = adf4377_iio_reg_write,
 };
@@ -46,11 +46,68 @@
 #include "iio_types.h"
 #include "adf4377.h"
 
+/******************************************************************************/
+/********************** Macros and Constants Definitions **********************/
+/******************************************************************************/
+#define ADF4377_IIO_REGMAP_STR_LEN	(2 * ADF4377_REGMAP_SIZE)
+/* Longest trace line: time, address, value, flags and status */
+#define ADF4377_IIO_TRACE_LINE_LEN	24
+
 /******************************************************************************/
 /*************************** Types Declarations *******************************/
 /******************************************************************************/
 
+/**
+ * @enum adf4377_iio_scan
+ * @brief Scan elements of the buffered status capture.
+ */
+enum adf4377_iio_scan {
+	ADF4377_IIO_SCAN_LOCKED,
+	ADF4377_IIO_SCAN_FSM_BUSY,
+	ADF4377_IIO_SCAN_VCO_BAND,
+	ADF4377_IIO_SCAN_TEMP,
+	ADF4377_IIO_SCAN_TIMESTAMP
+};
+
+/**
+ * @struct adf4377_iio_init_param
+ * @brief ADF4377 IIO Initialization Parameters.
+ */
+struct adf4377_iio_init_param {
+	/* ADF4377 Device Descriptor */
+	struct adf4377_dev *dev;
+	/* Optional Sample Timestamp Source, the sample sequence number is used
+	 * when not provided */
+	uint32_t (*get_timestamp)(void);
+};
+
+/**
+ * @struct adf4377_iio_dev
+ * @brief ADF4377 IIO Device Descriptor.
+ */
+struct adf4377_iio_dev {
+	/* ADF4377 Device Descriptor */
+	struct adf4377_dev *dev;
+	/* Sample Timestamp Source */
+	uint32_t (*get_timestamp)(void);
+	/* Active Scan Elements Mask */
+	uint32_t active_mask;
+	/* Sample Sequence Number */
+	uint32_t seq;
+};
+
 /** IIO Descriptor */
 extern struct iio_device const adf4377_iio_descriptor;
 
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/** ADF4377 IIO Initialization */
+int32_t adf4377_iio_init(struct adf4377_iio_dev **iio_dev,
+			 struct adf4377_iio_init_param *init_param);
+
+/** ADF4377 IIO Resources Deallocation */
+int32_t adf4377_iio_remove(struct adf4377_iio_dev *iio_dev);
+
 #endif //IIO_ADF4377_H
@@ -0,0 +1,376 @@
+/***************************************************************************//**
+ *   @file   adf4377_bench.c
+ *   @brief  ADF4377 driver benchmarks on the simulated platform.
+ *   @author Antoniu Miclaus (antoniu.miclaus@analog.com)
+********************************************************************************
+ * Copyright 2021(c) Analog Devices, Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *  - Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *  - The use of this software may or may not infringe the patent rights
+ *    of one or more patent holders.  This license does not release you
+ *    from the requirement that you obtain separate licenses from these
+ *    patent holders to use this software.
+ *  - Use of the software either in source or binary form, must be run
+ *    on or directly connected to an Analog Devices Inc. component.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, NON-INFRINGEMENT,
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ANALOG DEVICES BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, INTELLECTUAL PROPERTY RIGHTS, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include <inttypes.h>
+#include <stdio.h>
+#include "spi.h"
+#include "delay.h"
+#include "error.h"
+#include "util.h"
+#include "adf4377.h"
+#include "adf4377_sim.h"
+
+/******************************************************************************/
+/********************** Macros and Constants Definitions **********************/
+/******************************************************************************/
+#define ADF4377_BENCH_DEVS	4
+#define ADF4377_BENCH_HOPS	8
+#define ADF4377_BENCH_DWELL_US	50
+
+/******************************************************************************/
+/*************************** Types Declarations *******************************/
+/******************************************************************************/
+
+/**
+ * @struct adf4377_bench_mark
+ * @brief Model time at the start of a benchmark.
+ */
+struct adf4377_bench_mark {
+	/* Model Time in us */
+	uint64_t time_us;
+	/* Delay Time in us */
+	uint64_t delay_us;
+};
+
+/******************************************************************************/
+/************************ Variables Definitions *******************************/
+/******************************************************************************/
+static struct adf4377_sim sims[ADF4377_BENCH_DEVS];
+static struct spi_init_param spi_params[ADF4377_BENCH_DEVS];
+static struct adf4377_init_param init_params[ADF4377_BENCH_DEVS];
+
+static const uint64_t retune_freqs[] = {
+	2000000000, 4000000000, 6000000000, 1000000000
+};
+
+static const uint64_t hop_freqs[ADF4377_BENCH_HOPS] = {
+	1000000000, 1500000000, 2000000000, 3000000000,
+	4000000000, 5000000000, 6000000000, 8000000000
+};
+
+#ifdef ADF4377_ASYNC
+static struct adf4377_async_ops async_ops = {
+	.submit = adf4377_sim_async_submit,
+	.schedule = adf4377_sim_async_schedule
+};
+
+/* Status of the last asynchronous job, -EINPROGRESS while running */
+static volatile int32_t async_status;
+#endif
+
+#ifdef ADF4377_TRACE
+/* SPI trace of the first init */
+static struct adf4377_trace_rec init_trace[ADF4377_TRACE_SIZE];
+#endif
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/**
+ * @brief Put all the simulated devices in their power-on state and prepare
+ * their init parameters.
+ * @return None.
+ */
+static void adf4377_bench_power_on(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < ADF4377_BENCH_DEVS; i++) {
+		adf4377_sim_init(&sims[i]);
+
+		spi_params[i] = (struct spi_init_param) {
+			.max_speed_hz = 2000000,
+			.chip_select = i,
+			.mode = SPI_MODE_0,
+			.bit_order = SPI_BIT_ORDER_MSB_FIRST,
+			.platform_ops = &adf4377_sim_spi_ops,
+			.extra = &sims[i]
+		};
+
+		init_params[i] = (struct adf4377_init_param) {
+			.spi_init = &spi_params[i],
+			.spi3wire = ADF4377_SDO_ACTIVE_SPI_4W,
+			.clkin_freq = 100000000,
+			.cp_i = ADF4377_CP_10MA1,
+			.muxout_select = ADF4377_MUXOUT_HIGH_Z,
+			.ref_doubler_en = ADF4377_REF_DBLR_DIS,
+			.f_clk = 1000000000,
+			.clkout_op = ADF4377_CLKOUT_427MV,
+#ifdef ADF4377_ASYNC
+			.async_ops = &async_ops
+#endif
+		};
+	}
+}
+
+/**
+ * @brief Start a benchmark.
+ * @param mark - The benchmark start mark.
+ * @return None.
+ */
+static void adf4377_bench_start(struct adf4377_bench_mark *mark)
+{
+	uint8_t i;
+
+	for (i = 0; i < ADF4377_BENCH_DEVS; i++)
+		adf4377_sim_clear_counters(&sims[i]);
+
+	mark->time_us = adf4377_sim_time_us();
+	mark->delay_us = adf4377_sim_delay_us();
+}
+
+/**
+ * @brief Print the bus activity and model time of a benchmark.
+ * @param name - The benchmark name.
+ * @param ret - The benchmark status.
+ * @param mark - The benchmark start mark.
+ * @return None.
+ */
+static void adf4377_bench_report(const char *name, int32_t ret,
+				 const struct adf4377_bench_mark *mark)
+{
+	uint32_t xfers = 0, bytes = 0, cals = 0;
+	uint64_t bus_ns = 0;
+	uint8_t i;
+
+	for (i = 0; i < ADF4377_BENCH_DEVS; i++) {
+		xfers += sims[i].xfers;
+		bytes += sims[i].bytes;
+		bus_ns += sims[i].bus_ns;
+		cals += sims[i].cals;
+	}
+
+	printf("%-16s %5"PRId32" %6"PRIu32" %7"PRIu32" %5"PRIu32" %9"PRIu64
+	       " %9"PRIu64" %9"PRIu64"\n", name, ret, xfers, bytes, cals,
+	       bus_ns / 1000, adf4377_sim_delay_us() - mark->delay_us,
+	       adf4377_sim_time_us() - mark->time_us);
+}
+
+#ifdef ADF4377_ASYNC
+/**
+ * @brief Completion callback of the asynchronous jobs.
+ * @param ctx - Unused.
+ * @param status - The job status.
+ * @return None.
+ */
+static void adf4377_bench_async_done(void *ctx, int32_t status)
+{
+	async_status = status;
+}
+
+/**
+ * @brief Retune without blocking, servicing the transport interrupts until
+ * the job completes.
+ * @param dev - The device structure.
+ * @param f_clk - Output frequency.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_bench_retune_async(struct adf4377_dev *dev,
+		uint64_t f_clk)
+{
+	int32_t ret;
+
+	async_status = -EINPROGRESS;
+
+	ret = adf4377_set_frequency_async(dev, f_clk, adf4377_bench_async_done,
+					  NULL);
+	if (ret != SUCCESS)
+		return ret;
+
+	while (adf4377_sim_async_irq())
+		;
+
+	return async_status;
+}
+#endif
+
+/**
+ * @brief Run a sweep over a hop table, the delays standing for the timer.
+ * @param dev - The device structure.
+ * @param table - Calibrated hop table.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_bench_sweep(struct adf4377_dev *dev,
+				   const struct adf4377_hop_entry *table)
+{
+	struct adf4377_sweep_step steps[ADF4377_BENCH_HOPS];
+	uint32_t dwell[ADF4377_BENCH_HOPS];
+	struct adf4377_sweep_param param = {
+		.table = table,
+		.dwell_us = dwell,
+		.steps = steps,
+		.num_steps = ADF4377_BENCH_HOPS,
+		.gate_lock = true
+	};
+	struct adf4377_sweep sweep;
+	uint32_t dwell_us;
+	int32_t ret;
+	uint8_t i;
+
+	for (i = 0; i < ADF4377_BENCH_HOPS; i++)
+		dwell[i] = ADF4377_BENCH_DWELL_US;
+
+	ret = adf4377_sweep_prepare(dev, &sweep, &param);
+	if (ret != SUCCESS)
+		return ret;
+
+	ret = adf4377_sweep_start(&sweep, &dwell_us);
+	while (ret == SUCCESS || ret == -EAGAIN) {
+		if (!sweep.active)
+			return SUCCESS;
+
+		udelay(dwell_us);
+		ret = adf4377_sweep_tick(&sweep, &dwell_us);
+	}
+
+	return ret;
+}
+
+/**
+ * @brief Run the benchmarks and print one line per benchmark.
+ *
+ * The bus time is computed from the SPI clock, the total time adds the
+ * delays, so the figures do not depend on the host the benchmark runs on.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int main(void)
+{
+	struct adf4377_dev *devs[ADF4377_BENCH_DEVS];
+	struct adf4377_hop_entry hops[ADF4377_BENCH_HOPS];
+	struct adf4377_bench_mark mark;
+#ifdef ADF4377_TRACE
+	uint16_t num_trace, mismatches;
+#endif
+	int32_t ret;
+	uint8_t i;
+
+	printf("%-16s %5s %6s %7s %5s %9s %9s %9s\n", "benchmark", "ret",
+	       "xfers", "bytes", "cals", "bus_us", "delay_us", "total_us");
+
+	adf4377_bench_power_on();
+
+	adf4377_bench_start(&mark);
+	ret = adf4377_init(&devs[0], &init_params[0]);
+	adf4377_bench_report("init", ret, &mark);
+	if (ret != SUCCESS)
+		return ret;
+
+#ifdef ADF4377_TRACE
+	num_trace = adf4377_trace_read(devs[0], init_trace,
+				       ARRAY_SIZE(init_trace));
+#endif
+
+	adf4377_bench_start(&mark);
+	for (i = 0; i < ARRAY_SIZE(retune_freqs); i++) {
+		ret = adf4377_set_frequency(devs[0], retune_freqs[i]);
+		if (ret != SUCCESS)
+			break;
+	}
+	adf4377_bench_report("retune", ret, &mark);
+
+#ifdef ADF4377_ASYNC
+	async_ops.ctx = devs[0]->spi_desc;
+
+	adf4377_bench_start(&mark);
+	for (i = 0; i < ARRAY_SIZE(retune_freqs); i++) {
+		ret = adf4377_bench_retune_async(devs[0], retune_freqs[i]);
+		if (ret != SUCCESS)
+			break;
+	}
+	adf4377_bench_report("retune_async", ret, &mark);
+#endif
+
+	adf4377_bench_start(&mark);
+	ret = adf4377_hop_table_calibrate(devs[0], hop_freqs, hops,
+					  ADF4377_BENCH_HOPS);
+	adf4377_bench_report("hop_calibrate", ret, &mark);
+
+	adf4377_bench_start(&mark);
+	for (i = 0; i < ADF4377_BENCH_HOPS && ret == SUCCESS; i++)
+		ret = adf4377_hop(devs[0], &hops[i]);
+	adf4377_bench_report("hop_replay", ret, &mark);
+
+	if (ret == SUCCESS) {
+		adf4377_bench_start(&mark);
+		ret = adf4377_bench_sweep(devs[0], hops);
+		adf4377_bench_report("sweep", ret, &mark);
+	}
+
+#ifdef ADF4377_TRACE
+	/* The init trace starts with a soft reset and brings the device up
+	 * again, its timed replay is expected to match the init benchmark */
+	if (ret == SUCCESS) {
+		adf4377_bench_start(&mark);
+		ret = adf4377_trace_replay(devs[0], init_trace, num_trace, true,
+					   &mismatches);
+		if (ret == SUCCESS && mismatches)
+			ret = -EIO;
+		adf4377_bench_report("init_replay", ret, &mark);
+	}
+#endif
+
+	adf4377_remove(devs[0]);
+
+	adf4377_bench_power_on();
+
+	adf4377_bench_start(&mark);
+	for (i = 0; i < ADF4377_BENCH_DEVS; i++) {
+		ret = adf4377_init(&devs[i], &init_params[i]);
+		if (ret != SUCCESS)
+			break;
+	}
+	adf4377_bench_report("init_serial", ret, &mark);
+
+	while (i--)
+		adf4377_remove(devs[i]);
+
+	adf4377_bench_power_on();
+
+	adf4377_bench_start(&mark);
+	ret = adf4377_group_init(devs, init_params, ADF4377_BENCH_DEVS);
+	adf4377_bench_report("init_group", ret, &mark);
+	if (ret != SUCCESS)
+		return ret;
+
+	return adf4377_group_remove(devs, ADF4377_BENCH_DEVS);
+}
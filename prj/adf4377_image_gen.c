@@ -0,0 +1,342 @@
+/***************************************************************************//**
+ *   @file   adf4377_image_gen.c
+ *   @brief  ADF4377 register image generator for the simulated platform.
+ *   @author Antoniu Miclaus (antoniu.miclaus@analog.com)
+********************************************************************************
+ * Copyright 2021(c) Analog Devices, Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *  - Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *  - The use of this software may or may not infringe the patent rights
+ *    of one or more patent holders.  This license does not release you
+ *    from the requirement that you obtain separate licenses from these
+ *    patent holders to use this software.
+ *  - Use of the software either in source or binary form, must be run
+ *    on or directly connected to an Analog Devices Inc. component.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, NON-INFRINGEMENT,
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ANALOG DEVICES BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, INTELLECTUAL PROPERTY RIGHTS, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "spi.h"
+#include "error.h"
+#include "util.h"
+#include "delay.h"
+#include "adf4377.h"
+#include "adf4377_sim.h"
+
+/******************************************************************************/
+/********************** Macros and Constants Definitions **********************/
+/******************************************************************************/
+#define ADF4377_IMAGE_GEN_SIZE		1024
+#define ADF4377_IMAGE_GEN_BYTES_PER_LINE	12
+
+/******************************************************************************/
+/************************ Variables Definitions *******************************/
+/******************************************************************************/
+static struct adf4377_sim sim;
+static uint8_t image[ADF4377_IMAGE_GEN_SIZE];
+static uint16_t image_len;
+static bool image_overflow;
+
+/* Register of the last record when it is a poll, -1 otherwise */
+static int16_t last_poll_reg = -1;
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/**
+ * @brief Append bytes to the image.
+ * @param data - The bytes.
+ * @param len - Number of bytes.
+ * @return None.
+ */
+static void adf4377_image_gen_put(const uint8_t *data, uint16_t len)
+{
+	if (image_len + len > sizeof(image)) {
+		image_overflow = true;
+		return;
+	}
+
+	memcpy(&image[image_len], data, len);
+	image_len += len;
+}
+
+/**
+ * @brief Convert a register value to its wire representation.
+ * @param desc - The SPI descriptor.
+ * @param val - The register value.
+ * @return The wire byte.
+ */
+static uint8_t adf4377_image_gen_wire(struct spi_desc *desc, uint8_t val)
+{
+	return desc->bit_order == SPI_BIT_ORDER_LSB_FIRST ?
+	       bit_swap_constant_8(val) : val;
+}
+
+/**
+ * @brief Record a transfer and forward it to the simulated device.
+ *
+ * Writes are recorded as is. Single reads of the reset and lock status
+ * registers become poll records, consecutive polls of the same register
+ * collapsing into one, all the other reads are verifications that are not
+ * needed when replaying a known sequence and are dropped.
+ * @param desc - The SPI descriptor.
+ * @param data - The transfer buffer.
+ * @param bytes_number - The transfer length.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_image_gen_write_and_read(struct spi_desc *desc,
+		uint8_t *data, uint16_t bytes_number)
+{
+	bool lsb = desc->bit_order == SPI_BIT_ORDER_LSB_FIRST;
+	uint8_t rec[5 + ADF4377_BUFF_SIZE_BYTES];
+	uint8_t cmd, addr;
+
+	cmd = lsb ? bit_swap_constant_8(data[1]) : data[0];
+	addr = lsb ? bit_swap_constant_8(data[0]) : data[1];
+
+	if (!(cmd & ADF4377_SPI_READ_CMD)) {
+		rec[0] = ADF4377_IMAGE_XFER;
+		rec[1] = bytes_number;
+		adf4377_image_gen_put(rec, 2);
+		adf4377_image_gen_put(data, bytes_number);
+		last_poll_reg = -1;
+	} else if (bytes_number == ADF4377_BUFF_SIZE_BYTES &&
+		   (addr == ADF4377_REG(0x00) || addr == ADF4377_REG(0x49)) &&
+		   last_poll_reg != addr) {
+		rec[0] = ADF4377_IMAGE_POLL;
+		if (addr == ADF4377_REG(0x00)) {
+			rec[1] = adf4377_image_gen_wire(desc,
+							ADF4377_SOFT_RESET(ADF4377_SOFT_RESET_EN));
+			rec[2] = 0;
+		} else {
+			rec[1] = adf4377_image_gen_wire(desc,
+							ADF4377_LOCKED_MSK | ADF4377_FSM_BUSY_MSK);
+			rec[2] = adf4377_image_gen_wire(desc, ADF4377_LOCKED_MSK);
+		}
+		/* Timeout filled in once the plan is known */
+		rec[3] = 0;
+		rec[4] = 0;
+		memcpy(&rec[5], data, ADF4377_SPI_INSTR_BYTES);
+		rec[5 + ADF4377_SPI_INSTR_BYTES] = ADF4377_SPI_DUMMY_DATA;
+		adf4377_image_gen_put(rec, sizeof(rec));
+		last_poll_reg = addr;
+	}
+
+	return adf4377_sim_spi_ops.write_and_read(desc, data, bytes_number);
+}
+
+/**
+ * @brief Fill in the poll timeouts of the image.
+ * @param lsb - Whether the image frames are LSB first.
+ * @param lock_timeout_us - The lock timeout of the frequency plan.
+ * @return None.
+ */
+static void adf4377_image_gen_timeouts(bool lsb, uint32_t lock_timeout_us)
+{
+	uint32_t timeout_us;
+	uint16_t i = 0;
+	uint8_t addr;
+
+	while (i < image_len) {
+		if (image[i] == ADF4377_IMAGE_XFER) {
+			i += 2 + image[i + 1];
+			continue;
+		}
+
+		addr = lsb ? bit_swap_constant_8(image[i + 5]) : image[i + 6];
+		timeout_us = addr == ADF4377_REG(0x00) ? ADF4377_RESET_TIMEOUT_US :
+			     lock_timeout_us;
+		timeout_us = min(timeout_us, (uint32_t)ADF4377_IMAGE_TIMEOUT_MAX_US);
+		image[i + 3] = timeout_us & 0xFF;
+		image[i + 4] = timeout_us >> 8;
+		i += 5 + ADF4377_BUFF_SIZE_BYTES;
+	}
+}
+
+/**
+ * @brief Transfer callback of the image replay check.
+ * @param ctx - The SPI descriptor.
+ * @param data - The wire frame.
+ * @param len - The frame length.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_image_gen_xfer(void *ctx, uint8_t *data, uint16_t len)
+{
+	return spi_write_and_read(ctx, data, len);
+}
+
+/**
+ * @brief Delay callback of the image replay check.
+ * @param ctx - The SPI descriptor, unused.
+ * @param us - The delay in us.
+ * @return None.
+ */
+static void adf4377_image_gen_delay_us(void *ctx, uint32_t us)
+{
+	udelay(us);
+}
+
+/**
+ * @brief Replay the image on a second simulated device and compare the
+ * resulting register file with the one left by adf4377_init().
+ * @param spi_param - The SPI init parameters used for the generation.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_image_gen_check(struct spi_init_param *spi_param)
+{
+	struct adf4377_image_ops ops = {
+		.xfer = adf4377_image_gen_xfer,
+		.delay_us = adf4377_image_gen_delay_us,
+	};
+	struct spi_init_param param = *spi_param;
+	struct adf4377_sim replay;
+	struct spi_desc *spi;
+	int32_t ret;
+
+	adf4377_sim_init(&replay);
+	param.platform_ops = &adf4377_sim_spi_ops;
+	param.extra = &replay;
+
+	ret = spi_init(&spi, &param);
+	if (ret != SUCCESS)
+		return ret;
+
+	ops.ctx = spi;
+	ret = adf4377_load_image(image, &ops);
+	if (ret == SUCCESS) {
+		fprintf(stderr, "replay: %"PRIu32" transfers, %"PRIu32" bytes\n",
+			replay.xfers, replay.bytes);
+		if (memcmp(replay.regs, sim.regs, sizeof(sim.regs)))
+			ret = FAILURE;
+	}
+
+	spi_remove(spi);
+
+	return ret;
+}
+
+/**
+ * @brief Print the image as a C array.
+ * @param init_param - The parameters the image was generated from.
+ * @return None.
+ */
+static void adf4377_image_gen_print(const struct adf4377_init_param *init_param)
+{
+	uint16_t i;
+
+	printf("/* Generated by adf4377_image_gen: clkin %"PRIu32" Hz, "
+	       "f_clk %"PRIu64" Hz, %u bytes */\n", init_param->clkin_freq,
+	       init_param->f_clk, image_len);
+	printf("const uint8_t adf4377_image[] = {");
+	for (i = 0; i < image_len; i++) {
+		if (!(i % ADF4377_IMAGE_GEN_BYTES_PER_LINE))
+			printf("\n\t");
+		else
+			printf(" ");
+		printf("0x%02X,", image[i]);
+	}
+	printf("\n};\n");
+}
+
+/**
+ * @brief Run adf4377_init() on the simulated device with a recording
+ * transport and print the resulting register image.
+ *
+ * The parameters match adf4377_sdz, the reference and output frequencies
+ * can be given in Hz as the first and second argument. The image only
+ * depends on the device and its parameters, so it can be generated on the
+ * host and linked in a first-stage bootloader.
+ * @param argc - Number of arguments.
+ * @param argv - The arguments.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int main(int argc, char **argv)
+{
+	struct spi_platform_ops record_ops = adf4377_sim_spi_ops;
+	struct spi_init_param spi_param = {
+		.max_speed_hz = 2000000,
+		.chip_select = 0,
+		.mode = SPI_MODE_0,
+		.bit_order = SPI_BIT_ORDER_MSB_FIRST,
+		.platform_ops = &record_ops,
+		.extra = &sim
+	};
+	struct adf4377_init_param init_param = {
+		.dev_id = ADF4377,
+		.spi_init = &spi_param,
+		.spi3wire = ADF4377_SDO_ACTIVE_SPI_4W,
+		.clkin_freq = 100000000,
+		.cp_i = ADF4377_CP_10MA1,
+		.muxout_select = ADF4377_MUXOUT_HIGH_Z,
+		.ref_doubler_en = ADF4377_REF_DBLR_DIS,
+		.f_clk = 1000000000,
+		.clkout_op = ADF4377_CLKOUT_427MV
+	};
+	struct adf4377_dev *dev;
+	int32_t ret;
+	uint8_t end = ADF4377_IMAGE_END;
+
+	if (argc > 1)
+		init_param.clkin_freq = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		init_param.f_clk = strtoull(argv[2], NULL, 0);
+
+	record_ops.write_and_read = adf4377_image_gen_write_and_read;
+	adf4377_sim_init(&sim);
+
+	ret = adf4377_init(&dev, &init_param);
+	if (ret != SUCCESS) {
+		fprintf(stderr, "adf4377_init failed: %"PRId32"\n", ret);
+		return ret;
+	}
+
+	adf4377_image_gen_timeouts(spi_param.bit_order == SPI_BIT_ORDER_LSB_FIRST,
+				   dev->plan.lock_timeout_us);
+	adf4377_image_gen_put(&end, 1);
+	adf4377_remove(dev);
+
+	if (image_overflow) {
+		fprintf(stderr, "image larger than %u bytes\n",
+			ADF4377_IMAGE_GEN_SIZE);
+		return -ENOMEM;
+	}
+
+	ret = adf4377_image_gen_check(&spi_param);
+	if (ret != SUCCESS) {
+		fprintf(stderr, "image replay check failed: %"PRId32"\n", ret);
+		return ret;
+	}
+
+	adf4377_image_gen_print(&init_param);
+
+	return SUCCESS;
+}
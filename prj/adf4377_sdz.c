@@ -54,6 +54,8 @@
 #ifdef IIO_SUPPORT
 #include "iio_app.h"
 #include "iio_adf4377.h"
+
+static uint8_t adf4377_iio_buff[ADF4377_IIO_BUFF_SIZE];
 #endif
 
 int main(void)
@@ -90,6 +92,18 @@ int main(void)
 		.extra = &xil_gpio_init
 	};
 
+	struct gpio_init_param gpio_lkdet_param = {
+		.number = GPIO_LKDET,
+		.platform_ops = &xil_gpio_platform_ops,
+		.extra = &xil_gpio_init
+	};
+
+	struct gpio_init_param gpio_muxout_param = {
+		.number = GPIO_MUXOUT,
+		.platform_ops = &xil_gpio_platform_ops,
+		.extra = &xil_gpio_init
+	};
+
 	struct spi_init_param spi_init = {
 		.max_speed_hz = 2000000,
 		.chip_select = SPI_ADF4377_CS,
@@ -100,14 +114,17 @@ int main(void)
 	};
 
 	struct adf4377_init_param adf4377_param = {
+		.dev_id = ADF4377,
 		.spi_init = &spi_init,
 		.gpio_ce_param = &gpio_ce_param,
 		.gpio_enclk1_param = &gpio_enclk1_param,
 		.gpio_enclk2_param = &gpio_enclk2_param,
+		.gpio_lkdet_param = &gpio_lkdet_param,
+		.gpio_muxout_param = &gpio_muxout_param,
 		.spi3wire = ADF4377_SDO_ACTIVE_SPI_4W,
 		.clkin_freq = 100000000,
 		.cp_i = ADF4377_CP_10MA1,
-		.muxout_select = ADF4377_MUXOUT_HIGH_Z,
+		.muxout_select = ADF4377_MUXOUT_REF_OK,
 		.ref_doubler_en = ADF4377_REF_DBLR_DIS,
 		.f_clk = 1000000000,
 		.clkout_op = ADF4377_CLKOUT_427MV
@@ -120,9 +137,24 @@ int main(void)
 	}
 
 #ifdef IIO_SUPPORT
+	struct adf4377_iio_dev *adf4377_iio_dev;
+	struct adf4377_iio_init_param adf4377_iio_param = {
+		.dev = dev,
+	};
+	struct iio_data_buffer adf4377_iio_rd_buf = {
+		.buff = adf4377_iio_buff,
+		.size = sizeof(adf4377_iio_buff)
+	};
+
+	ret = adf4377_iio_init(&adf4377_iio_dev, &adf4377_iio_param);
+	if (ret != SUCCESS) {
+		pr_err("ADF4377 IIO Initialization failed!\n");
+		return FAILURE;
+	}
+
 	struct iio_app_device devices[] = {
-		IIO_APP_DEVICE("adf4377_dev", dev, &adf4377_iio_descriptor,
-			       NULL, NULL),
+		IIO_APP_DEVICE("adf4377_dev", adf4377_iio_dev, &adf4377_iio_descriptor,
+			       &adf4377_iio_rd_buf, NULL),
 	};
 	return iio_app_run(devices, ARRAY_SIZE(devices));
 #endif
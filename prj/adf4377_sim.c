@@ -0,0 +1,561 @@
+/***************************************************************************//**
+ *   @file   adf4377_sim.c
+ *   @brief  Simulated ADF4377 SPI and GPIO platform.
+ *   @author Antoniu Miclaus (antoniu.miclaus@analog.com)
+********************************************************************************
+ * Copyright 2021(c) Analog Devices, Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *  - Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *  - The use of this software may or may not infringe the patent rights
+ *    of one or more patent holders.  This license does not release you
+ *    from the requirement that you obtain separate licenses from these
+ *    patent holders to use this software.
+ *  - Use of the software either in source or binary form, must be run
+ *    on or directly connected to an Analog Devices Inc. component.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, NON-INFRINGEMENT,
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ANALOG DEVICES BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, INTELLECTUAL PROPERTY RIGHTS, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include <stdlib.h>
+#include <string.h>
+#include "adf4377_sim.h"
+#include "delay.h"
+#include "error.h"
+#include "util.h"
+
+/******************************************************************************/
+/************************ Variables Definitions *******************************/
+/******************************************************************************/
+
+/* Model time, advanced by the SPI transfers and the delays */
+static uint64_t adf4377_sim_time_ns;
+
+/* Model time spent in delays */
+static uint64_t adf4377_sim_delay_ns;
+
+/* Transfer pending on the simulated non-blocking transport */
+static struct spi_desc *adf4377_sim_async_desc;
+static uint8_t *adf4377_sim_async_data;
+static uint16_t adf4377_sim_async_len;
+static void (*adf4377_sim_async_cb)(void *arg, int32_t status);
+static void *adf4377_sim_async_arg;
+
+/* Timer pending on the simulated non-blocking transport */
+static void (*adf4377_sim_timer_fn)(void *arg);
+static void *adf4377_sim_timer_arg;
+static uint32_t adf4377_sim_timer_us;
+
+/******************************************************************************/
+/************************ Functions Definitions *******************************/
+/******************************************************************************/
+
+/**
+ * @brief Bring the register file to its reset state.
+ * @param sim - The simulated device.
+ * @return None.
+ */
+static void adf4377_sim_reset(struct adf4377_sim *sim)
+{
+	memset(sim->regs, 0, sizeof(sim->regs));
+	sim->regs[ADF4377_REG(0x03)] = ADF4377_CHIP_TYPE;
+	sim->regs[ADF4377_REG(0x04)] = ADF4377_PRODUCT_ID_LSB;
+	sim->regs[ADF4377_REG(0x49)] = ADF4377_REF_OK(1);
+	sim->calibrating = false;
+}
+
+/**
+ * @brief Initialize a simulated device in its power-on state.
+ *
+ * The lock times and temperature can be changed after this call.
+ * @param sim - The simulated device.
+ * @return None.
+ */
+void adf4377_sim_init(struct adf4377_sim *sim)
+{
+	memset(sim, 0, sizeof(*sim));
+	sim->lock_time_us = ADF4377_SIM_LOCK_TIME_US;
+	sim->hop_lock_time_us = ADF4377_SIM_HOP_LOCK_TIME_US;
+	sim->temp = ADF4377_SIM_TEMP;
+	adf4377_sim_reset(sim);
+}
+
+/**
+ * @brief Clear the bus counters of a simulated device.
+ * @param sim - The simulated device.
+ * @return None.
+ */
+void adf4377_sim_clear_counters(struct adf4377_sim *sim)
+{
+	sim->xfers = 0;
+	sim->bytes = 0;
+	sim->bus_ns = 0;
+	sim->cals = 0;
+}
+
+/**
+ * @brief Get the model time.
+ * @return The model time in us.
+ */
+uint64_t adf4377_sim_time_us(void)
+{
+	return adf4377_sim_time_ns / 1000;
+}
+
+/**
+ * @brief Get the model time spent in delays.
+ * @return The delay time in us.
+ */
+uint64_t adf4377_sim_delay_us(void)
+{
+	return adf4377_sim_delay_ns / 1000;
+}
+
+/**
+ * @brief Complete a pending calibration once its lock time has elapsed.
+ * @param sim - The simulated device.
+ * @return None.
+ */
+static void adf4377_sim_update_status(struct adf4377_sim *sim)
+{
+	uint8_t *status = &sim->regs[ADF4377_REG(0x49)];
+
+	if (!sim->calibrating || adf4377_sim_time_ns < sim->lock_at_ns)
+		return;
+
+	*status &= ~ADF4377_FSM_BUSY_MSK;
+	*status |= ADF4377_LOCKED_MSK;
+	sim->calibrating = false;
+}
+
+/**
+ * @brief Start a VCO calibration, or a hop when the VCO core and band are
+ * manually selected.
+ * @param sim - The simulated device.
+ * @return None.
+ */
+static void adf4377_sim_start_cal(struct adf4377_sim *sim)
+{
+	uint8_t *regs = sim->regs;
+	uint16_t n_int;
+	bool manual;
+
+	manual = regs[ADF4377_REG(0x3D)] & ADF4377_O_VCO_CORE_MSK;
+	n_int = (field_get(ADF4377_N_INT_MSB_MSK, regs[ADF4377_REG(0x11)]) << 8) |
+		regs[ADF4377_REG(0x10)];
+
+	if (manual) {
+		regs[ADF4377_REG(0x4B)] = field_get(ADF4377_M_VCO_CORE_MSK,
+						    regs[ADF4377_REG(0x13)]);
+		regs[ADF4377_REG(0x4F)] = regs[ADF4377_REG(0x14)];
+	} else {
+		regs[ADF4377_REG(0x4B)] = n_int % 4;
+		regs[ADF4377_REG(0x4F)] = n_int & ADF4377_VCO_BAND_MSK;
+	}
+
+	regs[ADF4377_REG(0x49)] &= ~ADF4377_LOCKED_MSK;
+	regs[ADF4377_REG(0x49)] |= ADF4377_FSM_BUSY_MSK;
+	sim->lock_at_ns = adf4377_sim_time_ns + 1000ull *
+			  (manual ? sim->hop_lock_time_us : sim->lock_time_us);
+	sim->calibrating = true;
+	sim->cals++;
+}
+
+/**
+ * @brief Check if a register ignores writes.
+ * @param reg_addr - The register address.
+ * @return true for the identification and status registers.
+ */
+static bool adf4377_sim_read_only(uint8_t reg_addr)
+{
+	if (reg_addr >= ADF4377_REG(0x49))
+		return true;
+
+	return reg_addr >= ADF4377_REG(0x03) && reg_addr <= ADF4377_REG(0x0D) &&
+	       reg_addr != ADF4377_REG(0x0A);
+}
+
+/**
+ * @brief Handle a register write.
+ * @param sim - The simulated device.
+ * @param reg_addr - The register address.
+ * @param data - The written value.
+ * @return None.
+ */
+static void adf4377_sim_write(struct adf4377_sim *sim, uint8_t reg_addr,
+			      uint8_t data)
+{
+	int16_t temp = sim->temp;
+
+	if (adf4377_sim_read_only(reg_addr))
+		return;
+
+	switch (reg_addr) {
+	case ADF4377_REG(0x00):
+		if (data & (ADF4377_SOFT_RESET_MSK | ADF4377_SOFT_RESET_R_MSK))
+			adf4377_sim_reset(sim);
+		else
+			sim->regs[reg_addr] = data;
+		return;
+	case ADF4377_REG(0x45):
+		/* Conversions complete instantly, ADC_ST_CNV self-clears */
+		if (data & ADF4377_ADC_ST_CNV_MSK) {
+			sim->regs[ADF4377_REG(0x4C)] = temp & ADF4377_CHIP_TEMP_LSB_MSK;
+			sim->regs[ADF4377_REG(0x4D)] = (temp >> 8) & ADF4377_CHIP_TEMP_MSB_MSK;
+		}
+		return;
+	default:
+		sim->regs[reg_addr] = data;
+		if (reg_addr == ADF4377_REG(0x10))
+			adf4377_sim_start_cal(sim);
+		return;
+	}
+}
+
+/**
+ * @brief Initialize a simulated SPI descriptor.
+ * @param desc - The SPI descriptor.
+ * @param param - The SPI init parameters, extra pointing to the simulated
+ * 		  device.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_spi_init(struct spi_desc **desc,
+				    const struct spi_init_param *param)
+{
+	struct spi_desc *spi;
+
+	if (!param->extra || !param->max_speed_hz)
+		return -EINVAL;
+
+	spi = (struct spi_desc *)calloc(1, sizeof(*spi));
+	if (!spi)
+		return -ENOMEM;
+
+	spi->max_speed_hz = param->max_speed_hz;
+	spi->chip_select = param->chip_select;
+	spi->mode = param->mode;
+	spi->bit_order = param->bit_order;
+	spi->extra = param->extra;
+
+	*desc = spi;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Run a transfer against the simulated register file.
+ *
+ * The register address follows the ADDRESS_ASC setting of REG0x00 for
+ * streaming transfers, and the bus time is added to the model time. As on
+ * the real device, SDO only drives the read data: the instruction and write
+ * bytes of the buffer are overwritten by ADF4377_SIM_SDO_IDLE.
+ * @param desc - The SPI descriptor.
+ * @param data - The transfer buffer.
+ * @param bytes_number - The transfer length.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_spi_write_and_read(struct spi_desc *desc,
+		uint8_t *data, uint16_t bytes_number)
+{
+	struct adf4377_sim *sim = desc->extra;
+	bool lsb = desc->bit_order == SPI_BIT_ORDER_LSB_FIRST;
+	uint64_t bus_ns;
+	uint8_t cmd, addr, val;
+	uint16_t i;
+
+	if (bytes_number <= ADF4377_SPI_INSTR_BYTES)
+		return -EINVAL;
+
+	bus_ns = 8000000000ull * bytes_number / desc->max_speed_hz;
+	sim->xfers++;
+	sim->bytes += bytes_number;
+	sim->bus_ns += bus_ns;
+	adf4377_sim_time_ns += bus_ns;
+
+	adf4377_sim_update_status(sim);
+
+	cmd = lsb ? bit_swap_constant_8(data[1]) : data[0];
+	addr = lsb ? bit_swap_constant_8(data[0]) : data[1];
+	memset(data, ADF4377_SIM_SDO_IDLE, ADF4377_SPI_INSTR_BYTES);
+
+	for (i = ADF4377_SPI_INSTR_BYTES; i < bytes_number; i++) {
+		if (cmd & ADF4377_SPI_READ_CMD) {
+			val = addr < ADF4377_REGMAP_SIZE ? sim->regs[addr] : 0;
+			data[i] = lsb ? bit_swap_constant_8(val) : val;
+		} else {
+			val = lsb ? bit_swap_constant_8(data[i]) : data[i];
+			adf4377_sim_write(sim, addr, val);
+			data[i] = ADF4377_SIM_SDO_IDLE;
+		}
+
+		if (sim->regs[ADF4377_REG(0x00)] & ADF4377_ADDRESS_ASC_MSK)
+			addr++;
+		else
+			addr--;
+	}
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Free a simulated SPI descriptor.
+ * @param desc - The SPI descriptor.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_spi_remove(struct spi_desc *desc)
+{
+	free(desc);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get a simulated GPIO descriptor.
+ * @param desc - The GPIO descriptor.
+ * @param param - The GPIO init parameters, extra pointing to the simulated
+ * 		  device.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_gpio_get(struct gpio_desc **desc,
+				    const struct gpio_init_param *param)
+{
+	struct gpio_desc *gpio;
+
+	if (!param->extra)
+		return -EINVAL;
+
+	gpio = (struct gpio_desc *)calloc(1, sizeof(*gpio));
+	if (!gpio)
+		return -ENOMEM;
+
+	gpio->number = param->number;
+	gpio->extra = param->extra;
+
+	*desc = gpio;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Get an optional simulated GPIO descriptor.
+ * @param desc - The GPIO descriptor, NULL when no parameters are given.
+ * @param param - The GPIO init parameters.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_gpio_get_optional(struct gpio_desc **desc,
+		const struct gpio_init_param *param)
+{
+	if (!param) {
+		*desc = NULL;
+		return SUCCESS;
+	}
+
+	return adf4377_sim_gpio_get(desc, param);
+}
+
+/**
+ * @brief Free a simulated GPIO descriptor.
+ * @param desc - The GPIO descriptor.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+static int32_t adf4377_sim_gpio_remove(struct gpio_desc *desc)
+{
+	free(desc);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Set a simulated GPIO as input.
+ * @param desc - The GPIO descriptor.
+ * @return SUCCESS.
+ */
+static int32_t adf4377_sim_gpio_direction_input(struct gpio_desc *desc)
+{
+	return SUCCESS;
+}
+
+/**
+ * @brief Set a simulated GPIO as output.
+ * @param desc - The GPIO descriptor.
+ * @param value - The output value.
+ * @return SUCCESS.
+ */
+static int32_t adf4377_sim_gpio_direction_output(struct gpio_desc *desc,
+		uint8_t value)
+{
+	return SUCCESS;
+}
+
+/**
+ * @brief Set the value of a simulated GPIO.
+ * @param desc - The GPIO descriptor.
+ * @param value - The output value.
+ * @return SUCCESS.
+ */
+static int32_t adf4377_sim_gpio_set_value(struct gpio_desc *desc,
+		uint8_t value)
+{
+	return SUCCESS;
+}
+
+/**
+ * @brief Get the value of a simulated GPIO, the lock detect output of the
+ * device for inputs.
+ * @param desc - The GPIO descriptor.
+ * @param value - The input value.
+ * @return SUCCESS.
+ */
+static int32_t adf4377_sim_gpio_get_value(struct gpio_desc *desc,
+		uint8_t *value)
+{
+	struct adf4377_sim *sim = desc->extra;
+
+	adf4377_sim_update_status(sim);
+
+	*value = field_get(ADF4377_LOCKED_MSK, sim->regs[ADF4377_REG(0x49)]);
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Start a transfer on the simulated non-blocking transport.
+ *
+ * The transfer only runs when adf4377_sim_async_irq() is called, like a DMA
+ * transfer completing in its interrupt.
+ * @param ctx - The SPI descriptor.
+ * @param data - The transfer buffer.
+ * @param len - The transfer length.
+ * @param done - Completion callback.
+ * @param arg - Completion callback argument.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_sim_async_submit(void *ctx, uint8_t *data, uint16_t len,
+				 void (*done)(void *arg, int32_t status),
+				 void *arg)
+{
+	if (!ctx || adf4377_sim_async_desc)
+		return -EBUSY;
+
+	adf4377_sim_async_desc = ctx;
+	adf4377_sim_async_data = data;
+	adf4377_sim_async_len = len;
+	adf4377_sim_async_cb = done;
+	adf4377_sim_async_arg = arg;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Start a timer on the simulated non-blocking transport.
+ *
+ * The timer expires when adf4377_sim_async_irq() is called, advancing the
+ * model time by its period.
+ * @param ctx - Unused.
+ * @param us - The timer period in us.
+ * @param fn - Expiry callback.
+ * @param arg - Expiry callback argument.
+ * @return SUCCESS in case of success, negative error code otherwise.
+ */
+int32_t adf4377_sim_async_schedule(void *ctx, uint32_t us,
+				   void (*fn)(void *arg), void *arg)
+{
+	if (adf4377_sim_timer_fn)
+		return -EBUSY;
+
+	adf4377_sim_timer_fn = fn;
+	adf4377_sim_timer_arg = arg;
+	adf4377_sim_timer_us = us;
+
+	return SUCCESS;
+}
+
+/**
+ * @brief Run the pending transfer and call its completion callback, or
+ * expire the pending timer.
+ * @return true if a transfer or timer was pending, false otherwise.
+ */
+bool adf4377_sim_async_irq(void)
+{
+	struct spi_desc *desc = adf4377_sim_async_desc;
+	void (*fn)(void *arg) = adf4377_sim_timer_fn;
+	int32_t ret;
+
+	if (!desc && fn) {
+		adf4377_sim_timer_fn = NULL;
+		udelay(adf4377_sim_timer_us);
+		fn(adf4377_sim_timer_arg);
+
+		return true;
+	}
+
+	if (!desc)
+		return false;
+
+	adf4377_sim_async_desc = NULL;
+	ret = adf4377_sim_spi_write_and_read(desc, adf4377_sim_async_data,
+					     adf4377_sim_async_len);
+	adf4377_sim_async_cb(adf4377_sim_async_arg, ret);
+
+	return true;
+}
+
+/**
+ * @brief Advance the model time, replaces the platform delay.
+ * @param usecs - The delay in us.
+ * @return None.
+ */
+void udelay(uint32_t usecs)
+{
+	adf4377_sim_time_ns += 1000ull * usecs;
+	adf4377_sim_delay_ns += 1000ull * usecs;
+}
+
+/**
+ * @brief Advance the model time, replaces the platform delay.
+ * @param msecs - The delay in ms.
+ * @return None.
+ */
+void mdelay(uint32_t msecs)
+{
+	udelay(msecs * 1000);
+}
+
+const struct spi_platform_ops adf4377_sim_spi_ops = {
+	.init = adf4377_sim_spi_init,
+	.write_and_read = adf4377_sim_spi_write_and_read,
+	.remove = adf4377_sim_spi_remove,
+};
+
+const struct gpio_platform_ops adf4377_sim_gpio_ops = {
+	.gpio_ops_get = adf4377_sim_gpio_get,
+	.gpio_ops_get_optional = adf4377_sim_gpio_get_optional,
+	.gpio_ops_remove = adf4377_sim_gpio_remove,
+	.gpio_ops_direction_input = adf4377_sim_gpio_direction_input,
+	.gpio_ops_direction_output = adf4377_sim_gpio_direction_output,
+	.gpio_ops_set_value = adf4377_sim_gpio_set_value,
+	.gpio_ops_get_value = adf4377_sim_gpio_get_value,
+};
@@ -0,0 +1,127 @@
+/***************************************************************************//**
+ *   @file   adf4377_sim.h
+ *   @brief  Simulated ADF4377 SPI and GPIO platform.
+ *   @author Antoniu Miclaus (antoniu.miclaus@analog.com)
+********************************************************************************
+ * Copyright 2021(c) Analog Devices, Inc.
+ *
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *  - Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ *  - Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ *  - Neither the name of Analog Devices, Inc. nor the names of its
+ *    contributors may be used to endorse or promote products derived
+ *    from this software without specific prior written permission.
+ *  - The use of this software may or may not infringe the patent rights
+ *    of one or more patent holders.  This license does not release you
+ *    from the requirement that you obtain separate licenses from these
+ *    patent holders to use this software.
+ *  - Use of the software either in source or binary form, must be run
+ *    on or directly connected to an Analog Devices Inc. component.
+ *
+ * THIS SOFTWARE IS PROVIDED BY ANALOG DEVICES "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, NON-INFRINGEMENT,
+ * MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL ANALOG DEVICES BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT
+ * LIMITED TO, INTELLECTUAL PROPERTY RIGHTS, PROCUREMENT OF SUBSTITUTE GOODS OR
+ * SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER
+ * CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+ * OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE
+ * OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+*******************************************************************************/
+
+#ifndef ADF4377_SIM_H_
+#define ADF4377_SIM_H_
+
+/******************************************************************************/
+/***************************** Include Files **********************************/
+/******************************************************************************/
+#include <stdint.h>
+#include <stdbool.h>
+#include "spi.h"
+#include "gpio.h"
+#include "adf4377.h"
+
+/******************************************************************************/
+/********************** Macros and Constants Definitions **********************/
+/******************************************************************************/
+#define ADF4377_SIM_LOCK_TIME_US	40
+#define ADF4377_SIM_HOP_LOCK_TIME_US	10
+#define ADF4377_SIM_TEMP		25
+/* Level read back while SDO does not drive the read data */
+#define ADF4377_SIM_SDO_IDLE		0x00
+
+/******************************************************************************/
+/*************************** Types Declarations *******************************/
+/******************************************************************************/
+
+/**
+ * @struct adf4377_sim
+ * @brief Simulated ADF4377, passed as the extra parameter of the SPI and GPIO
+ * init structures.
+ */
+struct adf4377_sim {
+	/* Register File */
+	uint8_t regs[ADF4377_REGMAP_SIZE];
+	/* Lock Time after a VCO Calibration in us */
+	uint32_t lock_time_us;
+	/* Lock Time with Manual VCO Core and Band Selection in us */
+	uint32_t hop_lock_time_us;
+	/* Die Temperature in degrees Celsius */
+	int16_t temp;
+	/* Model Time of the Lock, valid while calibrating */
+	uint64_t lock_at_ns;
+	/* Calibration in Progress */
+	bool calibrating;
+	/* SPI Transfers */
+	uint32_t xfers;
+	/* SPI Bytes */
+	uint32_t bytes;
+	/* Bus Time in ns */
+	uint64_t bus_ns;
+	/* VCO Calibrations and Hops Started */
+	uint32_t cals;
+};
+
+/******************************************************************************/
+/************************ Functions Declarations ******************************/
+/******************************************************************************/
+
+/** Simulated Platform SPI Operations */
+extern const struct spi_platform_ops adf4377_sim_spi_ops;
+
+/** Simulated Platform GPIO Operations */
+extern const struct gpio_platform_ops adf4377_sim_gpio_ops;
+
+/** Initialize a Simulated Device in its Power-On State */
+void adf4377_sim_init(struct adf4377_sim *sim);
+
+/** Clear the Bus Counters of a Simulated Device */
+void adf4377_sim_clear_counters(struct adf4377_sim *sim);
+
+/** Get the Model Time in us */
+uint64_t adf4377_sim_time_us(void);
+
+/** Get the Time Spent in Delays in us */
+uint64_t adf4377_sim_delay_us(void);
+
+/** Simulated Non-blocking Transport, the context is the SPI descriptor */
+int32_t adf4377_sim_async_submit(void *ctx, uint8_t *data, uint16_t len,
+				 void (*done)(void *arg, int32_t status),
+				 void *arg);
+
+/** Simulated Transport Timer */
+int32_t adf4377_sim_async_schedule(void *ctx, uint32_t us,
+				   void (*fn)(void *arg), void *arg);
+
+/** Complete the Pending Simulated Non-blocking Transfer or Timer */
+bool adf4377_sim_async_irq(void);
+
+#endif /* ADF4377_SIM_H_ */
@@ -42,5 +42,7 @@
 
 //#define XILINX_PLATFORM
 //#define IIO_SUPPORT
+/* The driver instrumentation is enabled by building with ADF4377_STATS=y */
+/* The SPI trace is enabled by building with ADF4377_TRACE=y */
 
 #endif /* APP_CONFIG_H_ */
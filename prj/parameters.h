@@ -58,6 +58,8 @@
 
 #define UART_BAUDRATE	            115200
 
+#define ADF4377_IIO_BUFF_SIZE		2048
+
 #define INTC_DEVICE_ID				XPAR_SCUGIC_SINGLE_DEVICE_ID
 
 #define GPIO_OFFSET					32 + 54
@@ -9,15 +9,26 @@
 #									       #
 ################################################################################
 
+ifeq (y,$(strip $(ADF4377_SIM)))
+ifeq (y,$(strip $(ADF4377_IMAGE_GEN)))
+SRCS += $(PROJECT)/src/adf4377_image_gen.c
+else
+SRCS += $(PROJECT)/src/adf4377_bench.c
+endif
+SRCS += $(PROJECT)/src/adf4377_sim.c
+else
 SRCS += $(PROJECT)/src/adf4377_sdz.c
+endif
 SRCS += $(DRIVERS)/spi/spi.c						\
 	$(DRIVERS)/gpio/gpio.c							\
 	$(DRIVERS)/frequency/adf4377/adf4377.c
+ifneq (y,$(strip $(ADF4377_SIM)))
 SRCS +=	$(PLATFORM_DRIVERS)/axi_io.c				\
 	$(PLATFORM_DRIVERS)/xilinx_spi.c				\
 	$(PLATFORM_DRIVERS)/xilinx_gpio.c				\
-	$(PLATFORM_DRIVERS)/delay.c						\
-	$(NO-OS)/util/util.c
+	$(PLATFORM_DRIVERS)/delay.c
+endif
+SRCS += $(NO-OS)/util/util.c
 ifeq (y,$(strip $(TINYIIOD)))
 LIBRARIES += iio
 SRCS += $(NO-OS)/util/xml.c						\
@@ -28,16 +39,41 @@ SRCS += $(NO-OS)/util/xml.c						\
 	$(NO-OS)/iio/iio_app/iio_app.c				\
 	$(DRIVERS)/frequency/adf4377/iio_adf4377.c
 endif
+ifeq (y,$(strip $(ADF4377_STATS)))
+CFLAGS += -DADF4377_STATS
+endif
+ifeq (y,$(strip $(ADF4377_ASYNC)))
+CFLAGS += -DADF4377_ASYNC
+endif
+ifeq (y,$(strip $(ADF4377_TRACE)))
+CFLAGS += -DADF4377_TRACE
+endif
+ifeq (msb,$(strip $(ADF4377_SPI_BIT_ORDER)))
+CFLAGS += -DADF4377_SPI_MSB_FIRST_ONLY
+endif
+ifeq (lsb,$(strip $(ADF4377_SPI_BIT_ORDER)))
+CFLAGS += -DADF4377_SPI_LSB_FIRST_ONLY
+endif
+ifeq (adf4377,$(strip $(ADF4377_DEVICE)))
+CFLAGS += -DADF4377_ADF4377_ONLY
+endif
+ifeq (adf4378,$(strip $(ADF4377_DEVICE)))
+CFLAGS += -DADF4377_ADF4378_ONLY
+endif
 INCS +=	$(PROJECT)/src/app_config.h					\
 	$(PROJECT)/src/parameters.h
 ifeq (y,$(strip $(TINYIIOD)))
 INCS +=	$(DRIVERS)/frequency/adf4377/iio_adf4377.h
 endif
 INCS += $(DRIVERS)/frequency/adf4377/adf4377.h
+ifeq (y,$(strip $(ADF4377_SIM)))
+INCS +=	$(PROJECT)/src/adf4377_sim.h
+else
 INCS +=	$(PLATFORM_DRIVERS)/spi_extra.h				\
-	$(PLATFORM_DRIVERS)/gpio_extra.h
-INCS +=	$(INCLUDE)/axi_io.h							\
-	$(INCLUDE)/spi.h								\
+	$(PLATFORM_DRIVERS)/gpio_extra.h				\
+	$(INCLUDE)/axi_io.h
+endif
+INCS +=	$(INCLUDE)/spi.h								\
 	$(INCLUDE)/gpio.h								\
 	$(INCLUDE)/error.h								\
 	$(INCLUDE)/delay.h								\